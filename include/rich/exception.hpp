@@ -1,35 +1,237 @@
 /// @file exception.hpp
 #pragma once
+#include <array>
+#include <atomic>
+#include <cstring> // std::memcpy
 #include <exception>
+#include <memory> // std::shared_ptr
+#include <new>    // ::operator new, ::operator delete
 #include <source_location>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <fmt/format.h>
 
 #include <rich/fundamental.hpp>
+#include <rich/stacktrace.hpp>
 
 namespace rich {
+  namespace detail {
+    // immutable, reference counted, null terminated string
+    struct shared_message {
+    private:
+      std::atomic<std::size_t> refs_{1};
+      std::size_t size_ = 0;
+
+      explicit shared_message(const std::size_t size) : size_(size) {}
+
+    public:
+      static shared_message* make(const std::string_view sv) {
+        void* p = ::operator new(sizeof(shared_message) + sv.size() + 1);
+        auto* m = ::new (p) shared_message(sv.size());
+        std::memcpy(m->data(), sv.data(), sv.size());
+        m->data()[sv.size()] = '\0';
+        return m;
+      }
+      static void retain(shared_message* m) noexcept {
+        if (m != nullptr)
+          m->refs_.fetch_add(1, std::memory_order_relaxed);
+      }
+      static void release(shared_message* m) noexcept {
+        if (m != nullptr
+            and m->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          m->~shared_message();
+          ::operator delete(m);
+        }
+      }
+
+      char* data() noexcept { return reinterpret_cast<char*>(this + 1); }
+      std::size_t size() const noexcept { return size_; }
+    };
+
+    // 書式化を遅延できる引数
+    template <class T>
+    inline constexpr bool is_lazy_format_arg_v =
+      std::is_arithmetic_v<std::remove_cvref_t<T>>;
+
+    template <class... Ts>
+    void format_stored_args(fmt::memory_buffer& buf, fmt::string_view f,
+                            const std::byte* p) {
+      std::tuple<Ts...> values{};
+      std::apply(
+        [&p](auto&... v) {
+          ((std::memcpy(std::addressof(v), p, sizeof(v)), p += sizeof(v)),
+           ...);
+        },
+        values);
+      std::apply(
+        [&](const auto&... v) {
+          fmt::vformat_to(fmt::appender(buf), f, fmt::make_format_args(v...));
+        },
+        values);
+    }
+  } // namespace detail
+
+  /// located_format_string
+  /// A string literal together with the location of the call site. Only
+  /// constant character arrays are accepted, so the string is known to
+  /// outlive any exception refering to it. With arguments, the string is a
+  /// format string checked at compile time; without, it is the message as
+  /// is, braces included.
+  template <class... Args>
+  struct located_format_string {
+    fmt::string_view str;
+    std::source_location loc;
+
+    template <std::size_t N>
+    consteval located_format_string(
+      const char (&s)[N],
+      std::source_location l = std::source_location::current())
+      : str(s), loc(l) {
+      if constexpr (sizeof...(Args) != 0)
+        (void)fmt::format_string<Args...>(s);
+    }
+  };
+
   // https://github.com/llvm/llvm-project/blob/main/libcxx/include/exception
   // https://github.com/llvm/llvm-project/blob/main/libcxx/include/stdexcept
   // https://github.com/llvm/llvm-project/tree/main/libcxx/src/support/runtime
   // https://stackoverflow.com/questions/28640553/exception-class-with-a-char-constructor
+  /// NOTE: Constructing from a string literal does not allocate. A format
+  ///       string with small arithmetic arguments keeps the arguments inline
+  ///       and is formatted on the first call of `what()`. Other messages are
+  ///       stored in a reference counted buffer shared by copies.
   struct exception : std::exception {
+    static constexpr std::size_t inline_args_size = 32;
+
   private:
-    std::string msg_{};
+    using format_fn = void(fmt::memory_buffer&, fmt::string_view,
+                           const std::byte*);
+
+    // string literal, or format string if `format_` is not null
+    const char* literal_ = "";
+    std::size_t literal_size_ = 0;
+    format_fn* format_ = nullptr;
+    std::array<std::byte, inline_args_size> args_{};
+    mutable std::atomic<detail::shared_message*> msg_{nullptr};
     std::source_location loc_{};
+    // raw return addresses, captured only if `stacktrace::enabled()`
+    std::shared_ptr<const stacktrace> trace_{};
+
+    static std::shared_ptr<const stacktrace> capture() {
+      if (not stacktrace::enabled())
+        return nullptr;
+      // skip `capture` and the constructor
+      return std::make_shared<const stacktrace>(stacktrace::current(2));
+    }
+
+    template <class... Args>
+    static constexpr bool lazy_formattable =
+      (detail::is_lazy_format_arg_v<Args> and ...)
+      and (std::size_t{0} + ... + sizeof(std::remove_cvref_t<Args>))
+            <= inline_args_size;
 
   public:
-    explicit exception(const std::string& msg,
-                       std::source_location loc = std::source_location::current())
-      : msg_(msg), loc_(loc) {}
-    explicit exception(const char* msg,
+    /// Constructs from a string literal, which is the message as is, or from
+    /// a format string and its arguments.
+    template <class... Args>
+    requires(... and not std::same_as<std::remove_cvref_t<Args>,
+                                      std::source_location>)
+    explicit exception(located_format_string<std::type_identity_t<Args>...> f,
+                       Args&&... args)
+      : loc_(f.loc), trace_(capture()) {
+      const fmt::string_view sv = f.str;
+      if constexpr (lazy_formattable<Args...>) {
+        literal_ = sv.data();
+        literal_size_ = sv.size();
+        if constexpr (sizeof...(Args) == 0)
+          return;
+        format_ = &detail::format_stored_args<std::remove_cvref_t<Args>...>;
+        std::byte* p = args_.data();
+        ((std::memcpy(p, std::addressof(args), sizeof(args)),
+          p += sizeof(args)),
+         ...);
+      } else {
+        fmt::memory_buffer buf;
+        fmt::vformat_to(fmt::appender(buf), sv, fmt::make_format_args(args...));
+        msg_.store(detail::shared_message::make({buf.data(), buf.size()}),
+                   std::memory_order_relaxed);
+      }
+    }
+    /// Constructs from a string literal, which is the message as is, thrown
+    /// at `loc`.
+    explicit exception(located_format_string<> f, std::source_location loc)
+      : literal_(f.str.data()), literal_size_(f.str.size()), loc_(loc),
+        trace_(capture()) {}
+    /// Constructs from a runtime string. The string is copied once.
+    template <class S>
+    requires std::convertible_to<const S&, std::string_view>
+             and (not std::is_array_v<S>)
+    explicit exception(const S& msg,
                        std::source_location loc = std::source_location::current())
-      : msg_(msg), loc_(loc) {}
+      : msg_(detail::shared_message::make(std::string_view(msg))), loc_(loc),
+        trace_(capture()) {}
+    /// Constructs from a null terminated runtime buffer, which is copied.
+    template <std::size_t N>
+    explicit exception(
+      char (&msg)[N],
+      std::source_location loc = std::source_location::current())
+      : exception(std::string_view(msg), loc) {}
+
+    exception(const exception& other) noexcept
+      : std::exception(other), literal_(other.literal_),
+        literal_size_(other.literal_size_), format_(other.format_),
+        args_(other.args_), msg_(other.msg_.load(std::memory_order_acquire)),
+        loc_(other.loc_), trace_(other.trace_) {
+      detail::shared_message::retain(msg_.load(std::memory_order_relaxed));
+    }
+    exception& operator=(const exception& other) noexcept {
+      if (this == std::addressof(other))
+        return *this;
+      auto* m = other.msg_.load(std::memory_order_acquire);
+      detail::shared_message::retain(m);
+      detail::shared_message::release(
+        msg_.exchange(m, std::memory_order_acq_rel));
+      std::exception::operator=(other);
+      literal_ = other.literal_;
+      literal_size_ = other.literal_size_;
+      format_ = other.format_;
+      args_ = other.args_;
+      loc_ = other.loc_;
+      trace_ = other.trace_;
+      return *this;
+    }
 
-    exception(const exception&) noexcept = default;
-    exception& operator=(const exception&) noexcept = default;
+    ~exception() noexcept override {
+      detail::shared_message::release(msg_.load(std::memory_order_relaxed));
+    }
 
-    ~exception() noexcept override = default;
-    const char* what() const noexcept override { return msg_.c_str(); }
+    const char* what() const noexcept override {
+      if (auto* m = msg_.load(std::memory_order_acquire))
+        return m->data();
+      if (format_ == nullptr)
+        return literal_;
+      try {
+        fmt::memory_buffer buf;
+        format_(buf, {literal_, literal_size_}, args_.data());
+        auto* m = detail::shared_message::make({buf.data(), buf.size()});
+        detail::shared_message* expected = nullptr;
+        if (msg_.compare_exchange_strong(expected, m,
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire))
+          return m->data();
+        // 他のスレッドが先に書式化した
+        detail::shared_message::release(m);
+        return expected->data();
+      } catch (...) {
+        // 書式化に失敗した場合は書式文字列を返す
+        return literal_;
+      }
+    }
     std::source_location where() const noexcept { return loc_; }
+    /// @return call stack at construction, or nullptr if it was not captured
+    const stacktrace* trace() const noexcept { return trace_.get(); }
   };
 
   // 雑に使える例外
@@ -3,13 +3,16 @@
 #include <fstream>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <rich/exception.hpp>
 #include <rich/math.hpp>
+#include <rich/trace.hpp>
 
 namespace rich {
   // https://kagasu.hatenablog.com/entry/2017/05/01/215219
-  std::string get_file_contents(const char* fname) {
+  inline std::string get_file_contents(const char* fname) {
+    [[maybe_unused]] const trace::scope ts("get_file_contents", "read");
     std::ifstream ifs(fname);
     if (!ifs)
       throw runtime_error("Failed to read file");
@@ -18,7 +21,7 @@ namespace rich {
     return ret;
   }
 
-  std::string get_file_contents(const std::string& fname) {
+  inline std::string get_file_contents(const std::string& fname) {
     return get_file_contents(fname.c_str());
   }
 
@@ -37,9 +40,10 @@ namespace rich {
     return sv.find(c, pos);
   }
 
-  std::string_view extract_partial_contents(std::string_view contents,
-                                            const std::uint_least32_t line,
-                                            const std::size_t extra_line) {
+  inline std::string_view
+  extract_partial_contents(std::string_view contents,
+                           const std::uint_least32_t line,
+                           const std::size_t extra_line) {
     const auto l = icast<std::size_t>(line);
     const auto a = sat_sub(l, extra_line + 1);
     auto first = find_nth(contents, '\n', a);
@@ -48,4 +52,64 @@ namespace rich {
     auto last = find_nth(contents, '\n', extra_line * 2 + 1, first);
     return contents.substr(first, last - first);
   }
+
+  /// line_index
+  /// Offsets of the beginning of each line of a text, built in a single pass.
+  /// Any line, or any range of lines, is then looked up in O(1).
+  template <class Char, class Traits = std::char_traits<Char>>
+  struct line_index {
+  private:
+    using string_view_type = std::basic_string_view<Char, Traits>;
+    string_view_type text_{};
+    // offsets_[i] is the beginning of the i-th line (0-based)
+    std::vector<std::size_t> offsets_{0};
+
+  public:
+    line_index() = default;
+    explicit line_index(string_view_type text) : text_(text) {
+      [[maybe_unused]] const trace::scope ts("line_index", "index");
+      for (auto pos = text_.find('\n'); pos != string_view_type::npos;
+           pos = text_.find('\n', pos + 1))
+        offsets_.push_back(pos + 1);
+    }
+
+    /// Rebinds to `text`, which must begin with the current text, and indexes
+    /// only the appended part.
+    void extend(string_view_type text) {
+      assert(text.size() >= text_.size());
+      [[maybe_unused]] const trace::scope ts("line_index::extend", "index");
+      const auto old_size = text_.size();
+      text_ = text;
+      for (auto pos = text_.find('\n', old_size);
+           pos != string_view_type::npos; pos = text_.find('\n', pos + 1))
+        offsets_.push_back(pos + 1);
+    }
+
+    string_view_type text() const noexcept { return text_; }
+    std::size_t size() const noexcept { return offsets_.size(); }
+
+    /// @return offset of the beginning of the `n`-th line (0-based)
+    std::size_t offset(const std::size_t n) const {
+      assert(n < size());
+      return offsets_[n];
+    }
+
+    /// @return the `n`-th line (0-based) without the newline
+    string_view_type line(const std::size_t n) const {
+      return slice(n, n + 1);
+    }
+
+    /// @return lines [first, last) (0-based) without the last newline
+    string_view_type slice(std::size_t first, std::size_t last) const {
+      last = last < size() ? last : size();
+      if (first >= last)
+        return text_.substr(text_.size());
+      const auto a = offsets_[first];
+      const auto b = last < size() ? offsets_[last] - 1 : text_.size();
+      return text_.substr(a, b - a);
+    }
+  };
+
+  template <class Char, class Traits>
+  line_index(std::basic_string_view<Char, Traits>) -> line_index<Char, Traits>;
 } // namespace rich
@@ -0,0 +1,262 @@
+/// @file follow.hpp
+#pragma once
+#include <chrono>
+#include <cstdint> // std::uintmax_t
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error> // std::error_code
+#include <thread>       // std::this_thread::sleep_for
+#include <utility>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <rich/exception.hpp>
+#include <rich/file.hpp>
+#include <rich/style/lines.hpp>
+#include <rich/style/syntax_highlight.hpp>
+
+namespace rich {
+  /// file_follower
+  /// Follows a growing file like `tail -F`. Following starts at the end of
+  /// the file, or at the beginning of its last `tail` complete lines. Only the
+  /// appended bytes are read and only the lines completed since the last
+  /// `flush` are highlighted; flushed lines are dropped, so the memory used
+  /// does not grow with the file.
+  /// When the file is truncated it is read again from the beginning, and when
+  /// it is replaced (e.g. renamed and recreated by log rotation) the rest of
+  /// the old file is read before the new one is opened. In both cases the
+  /// incomplete last line of the old contents is completed with a newline.
+  /// NOTE: A replaced file is detected only on Linux.
+  struct file_follower {
+  private:
+    std::string fname_{};
+    std::ifstream ifs_{};
+    // bytes read but not flushed yet: the lines completed since the last
+    // `flush` followed by the incomplete last line
+    std::string pending_{};
+    line_index<char> index_{};
+    // offset in the file of the end of `pending_`
+    std::uintmax_t pos_ = 0;
+    // number of the first line of `pending_`, counted from 1 since following
+    // started
+    std::size_t first_line_ = 1;
+#if defined(__linux__)
+    int fd_ = -1;
+    int wd_ = -1;
+    // identity of the file being read
+    dev_t dev_ = 0;
+    ino_t ino_ = 0;
+#endif
+
+    enum class file_change : unsigned char { none, truncated, replaced };
+
+    void open() {
+      ifs_.close();
+      ifs_.clear();
+      ifs_.open(fname_, std::ios::binary);
+      if (!ifs_)
+        throw runtime_error("Failed to read file");
+      pos_ = 0;
+#if defined(__linux__)
+      struct stat st {};
+      if (::stat(fname_.c_str(), &st) == 0) {
+        dev_ = st.st_dev;
+        ino_ = st.st_ino;
+      }
+#endif
+    }
+
+    void watch() {
+#if defined(__linux__)
+      if (fd_ == -1)
+        return;
+      if (wd_ != -1)
+        inotify_rm_watch(fd_, wd_);
+      wd_ = inotify_add_watch(fd_, fname_.c_str(),
+                              IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF
+                                | IN_ATTRIB);
+#endif
+    }
+
+    file_change detect() const {
+#if defined(__linux__)
+      struct stat st {};
+      // 再作成されるまでは古いファイルを読み続ける
+      if (::stat(fname_.c_str(), &st) != 0)
+        return file_change::none;
+      if (st.st_dev != dev_ or st.st_ino != ino_)
+        return file_change::replaced;
+      return icast<std::uintmax_t>(st.st_size) < pos_ ? file_change::truncated
+                                                      : file_change::none;
+#else
+      std::error_code ec;
+      const auto size = std::filesystem::file_size(fname_, ec);
+      return not ec and size < pos_ ? file_change::truncated
+                                    : file_change::none;
+#endif
+    }
+
+    // 読み直す前に、古い内容の途中の最後の行を完結させる
+    void complete_last_line() {
+      if (pending_.empty() or pending_.back() == '\n')
+        return;
+      pending_.push_back('\n');
+      index_.extend(pending_);
+    }
+
+    // @return offset of the beginning of the last `n` complete lines
+    std::uintmax_t tail_offset(std::size_t n) {
+      char buf[1 << 16];
+      auto end = pos_;
+      while (end != 0) {
+        const auto size = end < sizeof(buf) ? end : sizeof(buf);
+        const auto begin = end - size;
+        ifs_.seekg(icast<std::streamoff>(begin));
+        if (!ifs_.read(buf, icast<std::streamsize>(size)))
+          throw runtime_error("Failed to read file");
+        // 末尾から n + 1 個目の改行の直後から始まる
+        for (auto i = icast<std::size_t>(size); i-- > 0;)
+          if (buf[i] == '\n' and n-- == 0)
+            return begin + i + 1;
+        end = begin;
+      }
+      return 0;
+    }
+
+    std::size_t read_stream() {
+      const auto old_size = pending_.size();
+      ifs_.clear();
+      char buf[1 << 16];
+      while (ifs_.read(buf, sizeof(buf)) or ifs_.gcount() > 0)
+        pending_.append(buf, icast<std::size_t>(ifs_.gcount()));
+      index_.extend(pending_);
+      const auto n = pending_.size() - old_size;
+      pos_ += n;
+      return n;
+    }
+
+  public:
+    /// Starts following `fname` at its end. If `tail` is not 0, the last
+    /// `tail` complete lines are passed to the first `flush` as well.
+    explicit file_follower(std::string fname, const std::size_t tail = 0)
+      : fname_(std::move(fname)) {
+      open();
+#if defined(__linux__)
+      fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+      watch();
+      ifs_.seekg(0, std::ios::end);
+      pos_ = icast<std::uintmax_t>(std::streamoff(ifs_.tellg()));
+      if (tail != 0)
+        pos_ = tail_offset(tail);
+      ifs_.clear();
+      ifs_.seekg(icast<std::streamoff>(pos_));
+      read_appended();
+    }
+
+    file_follower(const file_follower&) = delete;
+    file_follower& operator=(const file_follower&) = delete;
+
+    ~file_follower() {
+#if defined(__linux__)
+      if (fd_ != -1)
+        ::close(fd_);
+#endif
+    }
+
+    // observer
+    /// @return the bytes read but not flushed yet
+    std::string_view pending() const noexcept { return pending_; }
+    /// @return line_index of `pending()`
+    const line_index<char>& index() const noexcept { return index_; }
+
+    /// Reads the bytes appended since the last call. Reads the file again
+    /// from the beginning if it was truncated or replaced.
+    /// @return the number of bytes read
+    std::size_t read_appended() {
+      std::size_t n = 0;
+      switch (detect()) {
+      case file_change::none:
+        break;
+      case file_change::truncated:
+        complete_last_line();
+        ifs_.clear();
+        ifs_.seekg(0);
+        pos_ = 0;
+        break;
+      case file_change::replaced:
+        n += read_stream();
+        complete_last_line();
+        open();
+        watch();
+        break;
+      }
+      return n + read_stream();
+    }
+
+    /// Blocks until the file is modified or `timeout` elapses. Uses inotify
+    /// on Linux and sleeps for `timeout` elsewhere, or while the file is
+    /// moved or deleted and not yet recreated.
+    /// @return false if it is known that the file was not modified
+    bool wait(const std::chrono::milliseconds timeout) {
+#if defined(__linux__)
+      if (fd_ != -1 and wd_ != -1) {
+        pollfd pfd{.fd = fd_, .events = POLLIN, .revents = 0};
+        if (::poll(&pfd, 1, icast<int>(timeout.count())) <= 0)
+          return false;
+        // drain events
+        alignas(inotify_event) char buf[4096];
+        bool gone = false;
+        for (ssize_t len = 0; (len = ::read(fd_, buf, sizeof(buf))) > 0;) {
+          for (ssize_t i = 0; i < len;) {
+            const auto* ev = reinterpret_cast<const inotify_event*>(buf + i);
+            if (ev->wd == wd_
+                and (ev->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED)))
+              gone = true;
+            i += icast<ssize_t>(sizeof(inotify_event) + ev->len);
+          }
+        }
+        // 再作成されたファイルは read_appended が開いて watch し直す
+        if (gone) {
+          inotify_rm_watch(fd_, wd_);
+          wd_ = -1;
+        }
+        return true;
+      }
+#endif
+      std::this_thread::sleep_for(timeout);
+      return true;
+    }
+
+    /// Calls `f(lns, first_line)` with the highlighted lines completed since
+    /// the last call, where `first_line` is the number of the first of them,
+    /// counted from 1 since following started. The incomplete last line is
+    /// kept until its newline arrives.
+    /// `lns` refers to `pending()` and is valid only during the call.
+    /// @return the number of lines passed to `f`
+    template <class F>
+    std::size_t flush(F&& f) {
+      // The last line of the index is always incomplete (possibly empty).
+      const auto n = index_.size() - 1;
+      if (n == 0)
+        return 0;
+      const auto last = index_.offset(n);
+      const auto chunk = std::string_view(pending_).substr(0, last);
+      // NOTE: `chunk` ends with a newline, so the last line of `lns` is empty.
+      const lines<char> lns(syntax_highlight(chunk), n);
+      std::forward<F>(f)(lns.subrange(0, n), first_line_);
+      first_line_ += n;
+      // flush した行は捨てる。残りの行は改行を含まない
+      pending_.erase(0, last);
+      index_ = line_index<char>(std::string_view(pending_));
+      return n;
+    }
+  };
+} // namespace rich
@@ -1,9 +1,11 @@
 /// @file format.hpp
 #pragma once
+#include <cstring>  // std::memcpy
 #include <iterator> // std::output_iterator
 #include <fmt/color.h>
 
 #include <rich/fundamental.hpp>
+#include <rich/instrument.hpp>
 #include <rich/ranges.hpp>
 
 namespace rich {
@@ -31,38 +33,118 @@ namespace rich {
 #define RICH_TYPED_LITERAL(Char, Literal)                                      \
   (rich::choose_literal<Char>::choose(Literal, L##Literal))
 
-  // copy_to
+  // fill_to
+
+  namespace detail {
+    /// Writes `sv` `n` times to `out`, which has room for them. The first copy
+    /// is written from `sv` and the filled run is then doubled.
+    template <typename Char>
+    Char* fill_contiguous(Char* out, std::basic_string_view<Char> sv,
+                          const std::size_t n) noexcept {
+      const auto total = sv.size() * n;
+      if (total == 0)
+        return out;
+      std::memcpy(out, sv.data(), sv.size() * sizeof(Char));
+      for (std::size_t done = sv.size(); done < total;) {
+        const auto m = done < total - done ? done : total - done;
+        std::memcpy(out + done, out, m * sizeof(Char));
+        done += m;
+      }
+      return out + total;
+    }
+  } // namespace detail
 
+  /// Writes `sv` `n` times to `out`. Pointers, fmt buffers and back inserters
+  /// of contiguous containers are filled in bulk.
   template <typename Char, std::output_iterator<const Char&> Out>
-  constexpr Out copy_to(Out out, std::basic_string_view<Char> sv,
-                        std::size_t n = 1) {
+  constexpr Out fill_to(Out out, std::basic_string_view<Char> sv,
+                        std::size_t n) {
+    if (not std::is_constant_evaluated()) {
+      const auto total = sv.size() * n;
+      if constexpr (std::same_as<Out, Char*>) {
+        return detail::fill_contiguous(out, sv, n);
+      } else if constexpr (std::same_as<Out, fmt::detail::buffer_appender<Char>>) {
+        auto it = fmt::detail::reserve(out, total);
+        if (auto p = fmt::detail::to_pointer<Char>(it, total)) {
+          detail::fill_contiguous(p, sv, n);
+          return it;
+        }
+      } else if constexpr (fmt::detail::is_contiguous_back_insert_iterator<
+                             Out>::value) {
+        auto& c = fmt::detail::get_container(out);
+        const auto size = c.size();
+        c.resize(size + total);
+        detail::fill_contiguous(c.data() + size, sv, n);
+        return out;
+      }
+    }
     while (n--)
       out = rich::ranges::copy(sv.data(), sv.data() + sv.size(), out).second;
     return out;
   }
 
+  // copy_to
+
+  template <typename Char, std::output_iterator<const Char&> Out>
+  constexpr Out copy_to(Out out, std::basic_string_view<Char> sv,
+                        std::size_t n = 1) {
+    if (n == 1)
+      return rich::ranges::copy(sv.data(), sv.data() + sv.size(), out).second;
+    return fill_to<Char>(out, sv, n);
+  }
+
+  // style_equal
+
+  constexpr bool style_equal(const fmt::text_style& x,
+                             const fmt::text_style& y) noexcept {
+    auto color_equal = [](const auto& a, const auto& b) {
+      if (a.is_rgb != b.is_rgb)
+        return false;
+      return a.is_rgb ? a.value.rgb_color == b.value.rgb_color
+                      : a.value.term_color == b.value.term_color;
+    };
+    if (x.has_emphasis() != y.has_emphasis()
+        or x.has_foreground() != y.has_foreground()
+        or x.has_background() != y.has_background())
+      return false;
+    if (x.has_emphasis() and x.get_emphasis() != y.get_emphasis())
+      return false;
+    if (x.has_foreground()
+        and not color_equal(x.get_foreground(), y.get_foreground()))
+      return false;
+    if (x.has_background()
+        and not color_equal(x.get_background(), y.get_background()))
+      return false;
+    return true;
+  }
+
   // set_style
 
   template <typename Char, std::output_iterator<const Char&> Out>
   auto set_style(Out out, const fmt::text_style& style)
     -> std::pair<Out, bool> {
+    instrument::add_set_style();
     bool has_style = false;
+    auto escape_to = [&out](const std::basic_string_view<Char> sv) {
+      instrument::add_escape(sv.size());
+      out = copy_to<Char>(out, sv);
+    };
     if (style.has_emphasis()) {
       has_style = true;
       auto emphasis = fmt::detail::make_emphasis<Char>(style.get_emphasis());
-      out = copy_to<Char>(out, (const Char*)emphasis);
+      escape_to((const Char*)emphasis);
     }
     if (style.has_foreground()) {
       has_style = true;
       auto foreground =
         fmt::detail::make_foreground_color<Char>(style.get_foreground());
-      out = copy_to<Char>(out, (const Char*)foreground);
+      escape_to((const Char*)foreground);
     }
     if (style.has_background()) {
       has_style = true;
       auto background =
         fmt::detail::make_background_color<Char>(style.get_background());
-      out = copy_to<Char>(out, (const Char*)background);
+      escape_to((const Char*)background);
     }
     return {out, has_style};
   }
@@ -71,7 +153,9 @@ namespace rich {
 
   template <typename Char, std::output_iterator<const Char&> Out>
   Out reset_style(Out out) {
-    return copy_to<Char>(out, RICH_TYPED_LITERAL(Char, "\x1b[0m"));
+    const std::basic_string_view<Char> sv = RICH_TYPED_LITERAL(Char, "\x1b[0m");
+    instrument::add_escape(sv.size());
+    return copy_to<Char>(out, sv);
   }
 
   // format_to
@@ -84,14 +168,16 @@ namespace rich {
                        const std::size_t left, const std::size_t right) {
     if (sv.empty() and (fill.empty() or (left == 0 and right == 0)))
       return out;
+    instrument::add_padding(fill.size() * (left + right));
+    instrument::add_text(sv.size());
     auto [out2, has_style] = set_style<Char>(out, style);
     out = out2;
     if (not fill.empty())
-      out = copy_to<Char>(out, fill, left);
+      out = fill_to<Char>(out, fill, left);
     if (not sv.empty())
       out = copy_to<Char>(out, sv);
     if (not fill.empty())
-      out = copy_to<Char>(out, fill, right);
+      out = fill_to<Char>(out, fill, right);
     if (has_style)
       out = reset_style<Char>(out);
     return out;
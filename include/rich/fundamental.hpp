@@ -17,7 +17,14 @@
 namespace rich {
 
 // RICH_UNREACHABLE
+// NOTE: NDEBUG でも -Wreturn-type を出さないように到達しないことを伝える
+#if defined(__GNUC__) or defined(__clang__)
+#define RICH_UNREACHABLE() (assert(false), __builtin_unreachable())
+#elif defined(_MSC_VER)
+#define RICH_UNREACHABLE() (assert(false), __assume(0))
+#else
 #define RICH_UNREACHABLE() (assert(false))
+#endif
 
   /// always_false
   template <class>
@@ -48,4 +55,16 @@ namespace rich {
     c.reserve(n);
     return c;
   }
+
+  /// make_reserved
+  template <class Cont, class Alloc>
+  // clang-format off
+  requires(not std::is_reference_v<Cont> and std::constructible_from<Cont, const Alloc&>
+    and requires(Cont & c, std::size_t n) { c.reserve(n); })
+  // clang-format on
+  Cont make_reserved(const std::size_t n, const Alloc& alloc) {
+    Cont c(alloc);
+    c.reserve(n);
+    return c;
+  }
 } // namespace rich
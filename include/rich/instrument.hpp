@@ -0,0 +1,344 @@
+/// @file instrument.hpp
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>         // std::free
+#include <memory_resource> // std::pmr::memory_resource
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+// RICH_INSTRUMENT
+// Defined to 1 to count the work done by each renderable type. Otherwise
+// every hook below is an empty inline function and costs nothing.
+#ifndef RICH_INSTRUMENT
+#define RICH_INSTRUMENT 0
+#endif
+
+#include <rich/fundamental.hpp>
+
+namespace rich::instrument {
+  inline constexpr bool enabled = RICH_INSTRUMENT;
+
+  /// @return demangled name of `T`
+  template <class T>
+  const std::string& type_name() {
+    static const std::string name = [] {
+      const char* mangled = typeid(T).name();
+#if __has_include(<cxxabi.h>)
+      int status = 0;
+      char* demangled =
+        abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+      std::string s = status == 0 ? demangled : mangled;
+      std::free(demangled);
+      return s;
+#else
+      return std::string(mangled);
+#endif
+    }();
+    return name;
+  }
+
+  /// counters
+  /// Work done while rendering one renderable type. Bytes are counted for
+  /// the innermost renderable writing them, time includes nested ones.
+  struct counters {
+    std::string name{};
+    std::uint64_t lines = 0;
+    std::uint64_t text_bytes = 0;
+    std::uint64_t padding_bytes = 0;
+    std::uint64_t escape_bytes = 0;
+    std::uint64_t set_style_calls = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t nanoseconds = 0;
+  };
+
+  /// snapshot
+  /// Counters of every renderable type rendered so far, in order of first
+  /// use. The first entry collects the work done outside any renderable.
+  struct snapshot {
+    std::vector<counters> entries{};
+  };
+
+  /// bytes
+  /// Bytes measured while rendering a string once, replayed every time the
+  /// string is copied to the output.
+  /// NOTE: The layout does not depend on RICH_INSTRUMENT, since it is a
+  ///       member of line_formatters which Iris::rich compiles.
+  struct bytes {
+    std::uint64_t text = 0;
+    std::uint64_t padding = 0;
+    std::uint64_t escape = 0;
+    std::uint64_t set_style_calls = 0;
+
+    bytes& operator+=([[maybe_unused]] const bytes& b) noexcept {
+      if constexpr (enabled) {
+        text += b.text;
+        padding += b.padding;
+        escape += b.escape;
+        set_style_calls += b.set_style_calls;
+      }
+      return *this;
+    }
+  };
+
+#if RICH_INSTRUMENT
+  namespace detail {
+    inline constexpr std::size_t max_slots = 128;
+
+    struct slot_t {
+      std::atomic<std::uint64_t> lines{0};
+      std::atomic<std::uint64_t> text_bytes{0};
+      std::atomic<std::uint64_t> padding_bytes{0};
+      std::atomic<std::uint64_t> escape_bytes{0};
+      std::atomic<std::uint64_t> set_style_calls{0};
+      std::atomic<std::uint64_t> allocations{0};
+      std::atomic<std::uint64_t> nanoseconds{0};
+    };
+
+    struct registry_t {
+      std::array<slot_t, max_slots> slots{};
+      std::mutex mtx{};
+      std::vector<std::string> names{"(none)"};
+
+      // 枠が足りなければ (none) にまとめる
+      std::size_t add(std::string name) {
+        std::lock_guard lock(mtx);
+        if (names.size() == max_slots)
+          return 0;
+        names.push_back(std::move(name));
+        return names.size() - 1;
+      }
+    };
+
+    inline registry_t& registry() {
+      static registry_t r{};
+      return r;
+    }
+
+    /// @return index of the slot counting `T`
+    template <class T>
+    std::size_t slot_of() {
+      static const std::size_t n = registry().add(type_name<T>());
+      return n;
+    }
+
+    inline thread_local std::size_t current_slot = 0;
+    // measure の間は slot ではなくここに数える
+    inline thread_local bytes* capture = nullptr;
+    // pause の間は行数、byte 数、時間を数えない
+    inline thread_local bool paused = false;
+
+    inline slot_t& current() { return registry().slots[current_slot]; }
+
+    inline void add(std::uint64_t bytes::*m,
+                    std::atomic<std::uint64_t> slot_t::*s,
+                    const std::uint64_t n) {
+      if (capture != nullptr)
+        capture->*m += n;
+      else if (not paused)
+        (current().*s).fetch_add(n, std::memory_order_relaxed);
+    }
+  } // namespace detail
+
+  // hooks
+
+  inline void add_text(const std::size_t n) {
+    detail::add(&bytes::text, &detail::slot_t::text_bytes, n);
+  }
+  inline void add_padding(const std::size_t n) {
+    detail::add(&bytes::padding, &detail::slot_t::padding_bytes, n);
+  }
+  inline void add_escape(const std::size_t n) {
+    detail::add(&bytes::escape, &detail::slot_t::escape_bytes, n);
+  }
+  inline void add_set_style() {
+    detail::add(&bytes::set_style_calls, &detail::slot_t::set_style_calls, 1);
+  }
+
+  /// Counts an allocation for the renderable being rendered. May be called
+  /// from a replaced `operator new`.
+  inline void record_allocation() noexcept {
+    detail::current().allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /// @return bytes written by `f()`, which are not counted
+  template <class F>
+  bytes measure(F&& f) {
+    bytes b{};
+    const auto prev = std::exchange(detail::capture, &b);
+    try {
+      std::forward<F>(f)();
+    } catch (...) {
+      detail::capture = prev;
+      throw;
+    }
+    detail::capture = prev;
+    return b;
+  }
+
+  /// Counts `b` as written by the renderable being rendered.
+  inline void replay(const bytes& b) {
+    if (detail::capture != nullptr) {
+      *detail::capture += b;
+      return;
+    }
+    if (detail::paused)
+      return;
+    auto& s = detail::current();
+    s.text_bytes.fetch_add(b.text, std::memory_order_relaxed);
+    s.padding_bytes.fetch_add(b.padding, std::memory_order_relaxed);
+    s.escape_bytes.fetch_add(b.escape, std::memory_order_relaxed);
+    s.set_style_calls.fetch_add(b.set_style_calls, std::memory_order_relaxed);
+  }
+
+  /// scope
+  /// Counts one line of `T` and the time until the end of the scope.
+  template <class T>
+  struct scope {
+  private:
+    std::size_t prev_;
+    std::chrono::steady_clock::time_point start_;
+
+  public:
+    scope()
+      : prev_(std::exchange(detail::current_slot, detail::slot_of<T>())),
+        start_(std::chrono::steady_clock::now()) {
+      if (not detail::paused)
+        detail::current().lines.fetch_add(1, std::memory_order_relaxed);
+    }
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+    ~scope() {
+      const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_);
+      if (not detail::paused)
+        detail::current().nanoseconds.fetch_add(
+          static_cast<std::uint64_t>(ns.count()), std::memory_order_relaxed);
+      detail::current_slot = prev_;
+    }
+  };
+
+  /// pause
+  /// Stops counting lines, bytes and time on this thread until the end of
+  /// the scope, for output which is rendered again later. Allocations and
+  /// `measure` are still counted.
+  struct pause {
+  private:
+    bool prev_;
+
+  public:
+    pause() : prev_(std::exchange(detail::paused, true)) {}
+    pause(const pause&) = delete;
+    pause& operator=(const pause&) = delete;
+    ~pause() { detail::paused = prev_; }
+  };
+
+  /// @return the counters so far
+  inline snapshot take_snapshot() {
+    auto& r = detail::registry();
+    std::lock_guard lock(r.mtx);
+    snapshot snap{};
+    snap.entries.reserve(r.names.size());
+    for (std::size_t i = 0; i < r.names.size(); ++i) {
+      const auto& s = r.slots[i];
+      constexpr auto relaxed = std::memory_order_relaxed;
+      snap.entries.push_back({
+        .name = r.names[i],
+        .lines = s.lines.load(relaxed),
+        .text_bytes = s.text_bytes.load(relaxed),
+        .padding_bytes = s.padding_bytes.load(relaxed),
+        .escape_bytes = s.escape_bytes.load(relaxed),
+        .set_style_calls = s.set_style_calls.load(relaxed),
+        .allocations = s.allocations.load(relaxed),
+        .nanoseconds = s.nanoseconds.load(relaxed),
+      });
+    }
+    return snap;
+  }
+
+  /// Sets every counter to zero. The renderable types stay registered.
+  inline void reset() {
+    auto& r = detail::registry();
+    std::lock_guard lock(r.mtx);
+    for (auto& s : r.slots) {
+      s.lines = 0;
+      s.text_bytes = 0;
+      s.padding_bytes = 0;
+      s.escape_bytes = 0;
+      s.set_style_calls = 0;
+      s.allocations = 0;
+      s.nanoseconds = 0;
+    }
+  }
+#else
+  // hooks
+  inline void add_text(const std::size_t) {}
+  inline void add_padding(const std::size_t) {}
+  inline void add_escape(const std::size_t) {}
+  inline void add_set_style() {}
+  inline void record_allocation() noexcept {}
+
+  template <class F>
+  bytes measure(F&& f) {
+    std::forward<F>(f)();
+    return {};
+  }
+
+  inline void replay(const bytes&) {}
+
+  template <class T>
+  struct scope {
+    scope() = default;
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+  };
+
+  struct pause {
+    pause() = default;
+    pause(const pause&) = delete;
+    pause& operator=(const pause&) = delete;
+  };
+
+  inline snapshot take_snapshot() { return {}; }
+  inline void reset() {}
+#endif
+
+  /// counting_resource
+  /// A memory resource counting its allocations for the renderable being
+  /// rendered, to be passed to the allocator-extended ctors.
+  struct counting_resource : std::pmr::memory_resource {
+  private:
+    std::pmr::memory_resource* upstream_;
+
+  public:
+    explicit counting_resource(
+      std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+      : upstream_(upstream) {}
+
+    std::pmr::memory_resource* upstream_resource() const { return upstream_; }
+
+  private:
+    void* do_allocate(const std::size_t n, const std::size_t align) override {
+      record_allocation();
+      return upstream_->allocate(n, align);
+    }
+
+    void do_deallocate(void* p, const std::size_t n,
+                       const std::size_t align) override {
+      upstream_->deallocate(p, n, align);
+    }
+
+    bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+      return this == &other;
+    }
+  };
+} // namespace rich::instrument
@@ -1,11 +1,66 @@
 /// @file iterator.hpp
 #pragma once
 #include <iterator>
-#include <memory> // std::shared_ptr
+#include <functional> // std::reference_wrapper
+#include <memory>     // std::shared_ptr
 
 #include <rich/fundamental.hpp>
 
 namespace rich {
+  /// null_output
+  /// An output iterator which discards every value assigned to it.
+  struct null_output {
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    template <class T>
+    requires (not std::same_as<std::remove_cvref_t<T>, null_output>)
+    constexpr const null_output& operator=(T&&) const noexcept {
+      return *this;
+    }
+
+    constexpr null_output& operator*() noexcept { return *this; }
+    constexpr null_output& operator++() noexcept { return *this; }
+    constexpr null_output operator++(int) noexcept { return *this; }
+  };
+
+  /// counting_output
+  /// An output iterator which discards every value assigned to it and counts
+  /// the number of increments.
+  struct counting_output {
+  private:
+    std::size_t count_ = 0;
+
+  public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    constexpr std::size_t count() const noexcept { return count_; }
+
+    template <class T>
+    requires (not std::same_as<std::remove_cvref_t<T>, counting_output>)
+    constexpr const counting_output& operator=(T&&) const noexcept {
+      return *this;
+    }
+
+    constexpr counting_output& operator*() noexcept { return *this; }
+    constexpr counting_output& operator++() noexcept {
+      ++count_;
+      return *this;
+    }
+    constexpr counting_output operator++(int) noexcept {
+      counting_output t(*this);
+      ++count_;
+      return t;
+    }
+  };
+
   template <class T>
   struct erased_output {
   private:
@@ -29,6 +84,16 @@ namespace rich {
           *(*std::static_pointer_cast<Out>(out))++ = std::move(t);
         }) {}
 
+    // NOTE: Writes through `o` itself, which must outlive every copy.
+    //       Nothing is allocated since the aliasing ctor of shared_ptr
+    //       without an owner does not make a control block.
+    template <std::output_iterator<T> Out>
+    constexpr explicit erased_output(std::reference_wrapper<Out> o)
+      : out_(base_ptr_t(), std::addressof(o.get())),
+        handler_([](base_ptr_t& out, U& t) {
+          *(*std::static_pointer_cast<Out>(out))++ = std::move(t);
+        }) {}
+
     constexpr erased_output&
     operator=(const U& t) requires std::copy_constructible<U> {
       U tmp{t};
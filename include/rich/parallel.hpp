@@ -0,0 +1,138 @@
+/// @file parallel.hpp
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rich {
+  /// @return number of workers to use by default
+  inline std::size_t default_concurrency() noexcept {
+    const auto n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+  }
+
+  /// thread_pool
+  /// A fixed set of workers executing one `parallel_for` at a time. The
+  /// calling thread takes part as worker 0.
+  struct thread_pool {
+  private:
+    struct job_t {
+      void (*run)(void*, std::size_t) = nullptr;
+      void* ctx = nullptr;
+    };
+
+    // `parallel_for` の呼び出しを直列化する
+    std::mutex submit_mtx_{};
+    std::mutex mtx_{};
+    std::condition_variable cv_{};
+    std::condition_variable done_cv_{};
+    job_t job_{};
+    std::uint64_t generation_ = 0;
+    std::size_t running_ = 0;
+    bool stop_ = false;
+    std::vector<std::thread> threads_{};
+
+    void worker_loop(const std::size_t worker) {
+      std::uint64_t seen = 0;
+      for (;;) {
+        job_t job;
+        {
+          std::unique_lock lock(mtx_);
+          cv_.wait(lock, [&] { return stop_ or generation_ != seen; });
+          if (stop_)
+            return;
+          seen = generation_;
+          job = job_;
+        }
+        job.run(job.ctx, worker);
+        {
+          std::lock_guard lock(mtx_);
+          if (--running_ == 0)
+            done_cv_.notify_one();
+        }
+      }
+    }
+
+  public:
+    /// @param threads total number of workers including the calling thread
+    explicit thread_pool(std::size_t threads = default_concurrency()) {
+      threads = threads == 0 ? 1 : threads;
+      threads_.reserve(threads - 1);
+      for (std::size_t w = 1; w < threads; ++w)
+        threads_.emplace_back([this, w] { worker_loop(w); });
+    }
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool() {
+      {
+        std::lock_guard lock(mtx_);
+        stop_ = true;
+      }
+      cv_.notify_all();
+      for (auto& t : threads_)
+        t.join();
+    }
+
+    /// @return number of workers including the calling thread
+    std::size_t size() const noexcept { return threads_.size() + 1; }
+
+    /// Calls `f(i, worker)` for every `i` in [0, n) and waits for completion.
+    /// Indices are handed out one at a time, so uneven work balances out.
+    /// `worker` is in [0, size()) and may be used to index per-thread state.
+    /// The first exception thrown by `f` is rethrown after all workers stop.
+    /// NOTE: Calling `parallel_for` of the same pool from `f` deadlocks.
+    template <class F>
+    void parallel_for(const std::size_t n, F&& f) {
+      if (n == 0)
+        return;
+      if (threads_.empty() or n == 1) {
+        for (std::size_t i = 0; i < n; ++i)
+          f(i, std::size_t{0});
+        return;
+      }
+
+      struct ctx_t {
+        F& f;
+        std::size_t n;
+        std::atomic<std::size_t> next{0};
+        std::mutex mtx{};
+        std::exception_ptr ep{};
+      } ctx{f, n};
+      auto run = [](void* p, const std::size_t worker) {
+        auto& c = *static_cast<ctx_t*>(p);
+        for (std::size_t i;
+             (i = c.next.fetch_add(1, std::memory_order_relaxed)) < c.n;) {
+          try {
+            c.f(i, worker);
+          } catch (...) {
+            std::lock_guard lock(c.mtx);
+            if (not c.ep)
+              c.ep = std::current_exception();
+            c.next.store(c.n, std::memory_order_relaxed);
+          }
+        }
+      };
+
+      std::lock_guard submit(submit_mtx_);
+      {
+        std::lock_guard lock(mtx_);
+        job_ = {run, &ctx};
+        running_ = threads_.size();
+        ++generation_;
+      }
+      cv_.notify_all();
+      run(&ctx, 0);
+      {
+        std::unique_lock lock(mtx_);
+        done_cv_.wait(lock, [&] { return running_ == 0; });
+      }
+      if (ctx.ep)
+        std::rethrow_exception(ctx.ep);
+    }
+  };
+} // namespace rich
@@ -6,6 +6,7 @@
 #include <string_view>
 
 #include <rich/fundamental.hpp>
+#include <rich/trace.hpp>
 
 namespace rich {
 
@@ -47,6 +48,7 @@ namespace rich {
     const std::basic_regex<Char, Traits>& re,
     std::regex_constants::match_flag_type flags =
       std::regex_constants::match_default) {
+    [[maybe_unused]] const trace::scope ts("regex_search", "highlight");
     return std::regex_search(sv.data(), sv.data() + sv.size(), m, re, flags);
   }
 
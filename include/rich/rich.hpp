@@ -1,8 +1,13 @@
 #include <rich/exception.hpp>
 #include <rich/file.hpp>
+#include <rich/follow.hpp>
 #include <rich/format.hpp>
+#include <rich/instrument.hpp>
 #include <rich/iterator.hpp>
 #include <rich/math.hpp>
+#include <rich/parallel.hpp>
 #include <rich/ranges.hpp>
 #include <rich/regex.hpp>
+#include <rich/stacktrace.hpp>
 #include <rich/style.hpp>
+#include <rich/trace.hpp>
@@ -0,0 +1,150 @@
+/// @file stacktrace.hpp
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib> // std::free
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#if __has_include(<execinfo.h>) and __has_include(<dlfcn.h>)
+#define RICH_HAS_STACKTRACE 1
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#else
+#define RICH_HAS_STACKTRACE 0
+#endif
+
+#include <rich/fundamental.hpp>
+
+namespace rich {
+  /// frame_info
+  struct frame_info {
+    const void* address = nullptr;
+    // demangled name of the enclosing symbol, empty if unknown
+    std::string function{};
+    // path of the object file containing `address`, empty if unknown
+    std::string object{};
+    // offset from the symbol, or from the object if the symbol is unknown
+    std::uintptr_t offset = 0;
+  };
+
+  namespace detail {
+    inline std::atomic<bool> stacktrace_enabled{false};
+
+    inline frame_info symbolize_uncached(const void* addr) {
+      frame_info fi{.address = addr};
+#if RICH_HAS_STACKTRACE
+      Dl_info info{};
+      if (::dladdr(addr, &info) == 0)
+        return fi;
+      const auto a = reinterpret_cast<std::uintptr_t>(addr);
+      if (info.dli_fname != nullptr)
+        fi.object = info.dli_fname;
+      if (info.dli_sname != nullptr) {
+        int status = 0;
+        char* demangled =
+          abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        fi.function = status == 0 ? demangled : info.dli_sname;
+        std::free(demangled);
+        fi.offset = a - reinterpret_cast<std::uintptr_t>(info.dli_saddr);
+      } else {
+        fi.offset = a - reinterpret_cast<std::uintptr_t>(info.dli_fbase);
+      }
+#endif
+      return fi;
+    }
+  } // namespace detail
+
+  /// Maximum number of addresses kept by the cache of `symbolize`.
+  inline constexpr std::size_t symbolize_cache_capacity = 1024;
+
+  namespace detail {
+    struct symbolize_cache {
+      std::mutex mtx{};
+      std::unordered_map<const void*, frame_info> map{};
+    };
+
+    inline symbolize_cache& get_symbolize_cache() {
+      static symbolize_cache cache;
+      return cache;
+    }
+  } // namespace detail
+
+  /// Symbolizes `addr`. The result is cached per address, so rendering the
+  /// same stack again does no symbol lookup.
+  /// The cache holds at most `symbolize_cache_capacity` addresses and is
+  /// cleared when it is full, so it does not grow in a long-running process.
+  /// NOTE: Symbols of the executable itself are found only if it is linked
+  ///       with `-rdynamic`; otherwise the object path and offset are given.
+  inline frame_info symbolize(const void* addr) {
+    auto& cache = detail::get_symbolize_cache();
+    {
+      std::lock_guard lock(cache.mtx);
+      if (auto it = cache.map.find(addr); it != cache.map.end())
+        return it->second;
+    }
+    // dladdr や demangle の間は lock を持たない
+    auto fi = detail::symbolize_uncached(addr);
+    std::lock_guard lock(cache.mtx);
+    if (cache.map.size() >= symbolize_cache_capacity)
+      cache.map.clear();
+    cache.map.try_emplace(addr, fi);
+    return fi;
+  }
+
+  /// stacktrace
+  /// Raw return addresses of a call stack. Capturing is cheap; symbolization
+  /// is deferred until the stacktrace is rendered.
+  struct stacktrace {
+    using char_type = char;
+    static constexpr std::size_t max_depth = 64;
+
+  private:
+    std::array<void*, max_depth> frames_{};
+    std::size_t size_ = 0;
+
+  public:
+    /// Enables or disables capturing in `rich::exception`.
+    static void enable(const bool b = true) noexcept {
+      detail::stacktrace_enabled.store(b, std::memory_order_relaxed);
+    }
+    static bool enabled() noexcept {
+      return detail::stacktrace_enabled.load(std::memory_order_relaxed);
+    }
+
+    /// Captures the current call stack, skipping the `skip` innermost frames
+    /// besides this function itself.
+    [[gnu::noinline]] static stacktrace current(std::size_t skip = 0) noexcept {
+      stacktrace st;
+#if RICH_HAS_STACKTRACE
+      const auto n = icast<std::size_t>(
+        ::backtrace(st.frames_.data(), icast<int>(st.frames_.size())));
+      skip = skip + 1 < n ? skip + 1 : n;
+      for (std::size_t i = skip; i < n; ++i)
+        st.frames_[i - skip] = st.frames_[i];
+      st.size_ = n - skip;
+#else
+      (void)skip;
+#endif
+      return st;
+    }
+
+    // observer
+    auto begin() const { return frames_.begin(); }
+    auto end() const { return frames_.begin() + icast<std::ptrdiff_t>(size_); }
+    auto empty() const { return size_ == 0; }
+    auto size() const { return size_; }
+    const void* operator[](const std::size_t n) const {
+      assert(n < size_);
+      return frames_[n];
+    }
+
+    /// @return symbolized `n`-th frame
+    frame_info frame(const std::size_t n) const {
+      return symbolize((*this)[n]);
+    }
+  };
+} // namespace rich
@@ -1,11 +1,21 @@
+#include <rich/style/batch.hpp>
+#include <rich/style/border.hpp>
 #include <rich/style/box.hpp>
 #include <rich/style/cell.hpp>
+#include <rich/style/compact_lines.hpp>
 #include <rich/style/enumerate.hpp>
+#include <rich/style/extern_template.hpp>
 #include <rich/style/format_spec.hpp>
+#include <rich/style/hexdump.hpp>
 #include <rich/style/line_formatter.hpp>
 #include <rich/style/lines.hpp>
+#include <rich/style/markup.hpp>
 #include <rich/style/panel.hpp>
 #include <rich/style/segment.hpp>
 #include <rich/style/segments.hpp>
+#include <rich/style/snapshot.hpp>
+#include <rich/style/stacktrace.hpp>
+#include <rich/style/static_table.hpp>
 #include <rich/style/syntax_highlight.hpp>
 #include <rich/style/table.hpp>
+#include <rich/style/text_arena.hpp>
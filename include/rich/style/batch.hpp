@@ -0,0 +1,88 @@
+/// @file batch.hpp
+#pragma once
+#include <span>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+
+#include <rich/parallel.hpp>
+#include <rich/style/line_formatter.hpp>
+
+namespace rich {
+  /// batch_buffers
+  /// Buffers the workers of `render_batch` render into, one per worker.
+  /// Keep one alive to reuse its memory across calls.
+  template <typename Char>
+  struct batch_buffers {
+    using buffer_type = fmt::basic_memory_buffer<Char>;
+    std::vector<buffer_type> buffers{};
+
+    /// Releases the memory of the buffers holding more than `n` code units.
+    void shrink(const std::size_t n = 0) {
+      for (auto& buf : buffers)
+        if (buf.capacity() > n)
+          buf = buffer_type();
+    }
+  };
+
+  // render_batch
+
+  /// Renders every item of `items` concurrently on `pool` and passes the
+  /// results to `sink` in input order, one `std::basic_string_view<Char>` per
+  /// item. Each item is rendered exactly as `fmt::format("{}", item)`.
+  /// Workers render into `bufs`, which keep their memory after the call.
+  /// Use `cell<Char>` as `L` to mix different renderables.
+  /// @return byte offsets of the items in the concatenated output, followed
+  ///         by the total size
+  /// NOTE: `sink` is called on the calling thread after all items are
+  ///       rendered, and must not pass `bufs` to another `render_batch`.
+  template <line_formattable L, class Sink>
+  requires std::invocable<Sink&, std::basic_string_view<typename L::char_type>>
+  std::vector<std::size_t>
+  render_batch(std::span<const L> items, Sink&& sink, thread_pool& pool,
+               batch_buffers<typename L::char_type>& bufs) {
+    using Char = typename L::char_type;
+    struct chunk_t {
+      std::size_t worker = 0;
+      std::size_t first = 0;
+      std::size_t size = 0;
+    };
+
+    if (bufs.buffers.size() < pool.size())
+      bufs.buffers.resize(pool.size());
+    for (auto& buf : bufs.buffers)
+      buf.clear();
+    std::vector<chunk_t> chunks(items.size());
+    pool.parallel_for(items.size(), [&](const std::size_t i,
+                                        const std::size_t worker) {
+      auto& buf = bufs.buffers[worker];
+      auto& chunk = chunks[i];
+      chunk.worker = worker;
+      chunk.first = buf.size();
+      line_formattable_format_to(fmt::detail::buffer_appender<Char>(buf),
+                                 items[i]);
+      chunk.size = buf.size() - chunk.first;
+    });
+
+    std::vector<std::size_t> offsets;
+    offsets.reserve(items.size() + 1);
+    std::size_t offset = 0;
+    for (const auto& chunk : chunks) {
+      offsets.push_back(offset);
+      offset += chunk.size;
+      const auto& buf = bufs.buffers[chunk.worker];
+      sink(std::basic_string_view<Char>(buf.data() + chunk.first, chunk.size));
+    }
+    offsets.push_back(offset);
+    return offsets;
+  }
+
+  /// Renders `items` like above into buffers released before returning.
+  template <line_formattable L, class Sink>
+  requires std::invocable<Sink&, std::basic_string_view<typename L::char_type>>
+  std::vector<std::size_t> render_batch(std::span<const L> items, Sink&& sink,
+                                        thread_pool& pool) {
+    batch_buffers<typename L::char_type> bufs;
+    return render_batch(items, std::forward<Sink>(sink), pool, bufs);
+  }
+} // namespace rich
@@ -0,0 +1,133 @@
+/// @file border.hpp
+#pragma once
+#include <array>
+#include <string>
+#include <string_view>
+
+#include <rich/format.hpp>
+#include <rich/instrument.hpp>
+#include <rich/style/format_spec.hpp>
+#include <rich/style/line_formatter.hpp>
+
+namespace rich {
+  // border_format_to
+
+  // ╭──title──╮
+  // ↑    ↑    ↑
+  // left mid  right
+  template <typename Char, std::output_iterator<const Char&> Out>
+  Out border_format_to(Out out, format_spec<Char> bs,
+                       std::basic_string_view<Char> left,
+                       std::basic_string_view<Char> mid,
+                       std::basic_string_view<Char> right,
+                       std::basic_string_view<Char> title,
+                       const std::size_t width) {
+    if (bs.align == align_t::left)
+      bs.fill = mid;
+    // clang-format off
+    out = spec_format_to<Char>(out, bs, left);
+    out = line_format_to<Char>(out, bs.style, title, mid, align_t::center, width);
+    out = rspec_format_to<Char>(out, bs, right);
+    // clang-format on
+    return out;
+  }
+
+  // border_cache
+
+  /// A small cache of rendered border rows. A row only depends on the border
+  /// spec, the glyphs, the title and the width, so panels and tables of the
+  /// same shape share their top, separator and bottom rows.
+  template <typename Char>
+  struct border_cache {
+  private:
+    using string_type = std::basic_string<Char>;
+    using string_view_type = std::basic_string_view<Char>;
+
+    struct entry {
+      // key
+      fmt::text_style style{};
+      string_type fill{};
+      align_t align{};
+      std::size_t spec_width = 0;
+      string_type left{}, mid{}, right{}, title{};
+      std::size_t width = 0;
+      // value
+      string_type rendered{};
+      instrument::bytes counts{};
+      bool valid = false;
+
+      bool matches(const format_spec<Char>& bs, string_view_type l,
+                   string_view_type m, string_view_type r, string_view_type t,
+                   const std::size_t w) const {
+        return valid and width == w and spec_width == bs.width
+               and align == bs.align and fill == bs.fill and left == l
+               and mid == m and right == r and title == t
+               and style_equal(style, bs.style);
+      }
+    };
+
+    std::array<entry, 8> entries_{};
+    std::size_t next_ = 0;
+
+  public:
+    /// @return the rendered border row, valid until the next call
+    /// @param counts receives the bytes of the row for rich/instrument.hpp
+    string_view_type get(const format_spec<Char>& bs, string_view_type left,
+                         string_view_type mid, string_view_type right,
+                         string_view_type title, const std::size_t width,
+                         instrument::bytes* counts = nullptr) {
+      for (const auto& e : entries_) {
+        if (e.matches(bs, left, mid, right, title, width)) {
+          if (counts != nullptr)
+            *counts = e.counts;
+          return e.rendered;
+        }
+      }
+
+      // round robin replacement
+      auto& e = entries_[next_];
+      next_ = (next_ + 1) % entries_.size();
+      e.style = bs.style;
+      e.fill = bs.fill;
+      e.align = bs.align;
+      e.spec_width = bs.width;
+      e.left = left;
+      e.mid = mid;
+      e.right = right;
+      e.title = title;
+      e.width = width;
+      e.rendered.clear();
+      e.counts = instrument::measure([&] {
+        border_format_to<Char>(std::back_inserter(e.rendered), bs, left, mid,
+                               right, title, width);
+      });
+      e.valid = true;
+      if (counts != nullptr)
+        *counts = e.counts;
+      return e.rendered;
+    }
+  };
+
+  /// @return the border_cache of the current thread
+  template <typename Char>
+  border_cache<Char>& thread_border_cache() {
+    thread_local border_cache<Char> cache{};
+    return cache;
+  }
+
+  // cached_border_format_to
+
+  template <typename Char, std::output_iterator<const Char&> Out>
+  Out cached_border_format_to(Out out, const format_spec<Char>& bs,
+                              std::basic_string_view<Char> left,
+                              std::basic_string_view<Char> mid,
+                              std::basic_string_view<Char> right,
+                              std::basic_string_view<Char> title,
+                              const std::size_t width) {
+    instrument::bytes counts{};
+    auto row = thread_border_cache<Char>().get(bs, left, mid, right, title,
+                                               width, &counts);
+    instrument::replay(counts);
+    return copy_to<Char>(out, row);
+  }
+} // namespace rich
@@ -1,8 +1,10 @@
 /// @file cell.hpp
 #pragma once
 #include <any>
-#include <iterator> // std::back_inserter
-#include <memory>   // std::shared_ptr
+#include <functional>      // std::ref
+#include <iterator>        // std::back_inserter
+#include <memory>          // std::shared_ptr, std::allocate_shared
+#include <memory_resource> // std::pmr::polymorphic_allocator
 
 #include <rich/format.hpp>
 #include <rich/iterator.hpp> // erased_output
@@ -11,6 +13,8 @@
 namespace rich {
   template <typename Char>
   struct cell {
+    using char_type = Char;
+
   private:
     std::shared_ptr<void> ptr_ = nullptr;
     std::any lfmtr_{};
@@ -24,6 +28,21 @@ namespace rich {
       handler_(&const_cast<std::any&>(lfmtr_), b, size, in, str);
     }
 
+    template <class LF>
+    static void handle(std::any* lfmtr, bool* b, std::size_t* size,
+                       const std::size_t* in, erased_output<Char>* erased) {
+      if (b != nullptr) {
+        *b = bool(*std::any_cast<const LF>(lfmtr));
+      } else if (size != nullptr and in != nullptr) {
+        *size = line_formatted_size(*std::any_cast<const LF>(lfmtr), *in);
+      } else if (size != nullptr) {
+        *size = std::any_cast<const LF>(lfmtr)->formatted_size();
+      } else {
+        assert(in != nullptr and erased != nullptr);
+        *erased = counted_format_to(*erased, *std::any_cast<LF>(lfmtr), *in);
+      }
+    }
+
   public:
     cell() = default;
 
@@ -34,17 +53,19 @@ namespace rich {
     cell(L&& l)
       : ptr_(std::make_shared<D>(std::forward<L>(l))),
         lfmtr_(std::make_any<LF>(*std::static_pointer_cast<D>(ptr_))),
-        handler_([](std::any* lfmtr, bool* b, std::size_t* size,
-                    const std::size_t* in, erased_output<Char>* erased) {
-          if (b != nullptr) {
-            *b = bool(*std::any_cast<const LF>(lfmtr));
-          } else if (size != nullptr) {
-            *size = std::any_cast<const LF>(lfmtr)->formatted_size();
-          } else {
-            assert(in != nullptr and erased != nullptr);
-            *erased = std::any_cast<LF>(lfmtr)->format_to(*erased, *in);
-          }
-        }) {}
+        handler_(&handle<LF>) {}
+
+    // allocator-extended ctor
+    // NOTE: The contents are allocated through `alloc`. The type-erased
+    //       line_formatter is still held by `std::any`.
+    template <line_formattable L, class D = std::remove_cvref_t<L>,
+              class LF = line_formatter<D, Char>>
+    requires (not std::same_as<std::remove_cvref_t<L>, cell>)
+    cell(std::allocator_arg_t, const std::pmr::polymorphic_allocator<>& alloc,
+         L&& l)
+      : ptr_(std::allocate_shared<D>(alloc, std::forward<L>(l))),
+        lfmtr_(std::make_any<LF>(*std::static_pointer_cast<D>(ptr_))),
+        handler_(&handle<LF>) {}
 
     explicit operator bool() const {
       assert(lfmtr_.has_value());
@@ -60,11 +81,23 @@ namespace rich {
       return size;
     }
 
+    std::size_t formatted_size(const std::size_t n) const {
+      assert(lfmtr_.has_value());
+      std::size_t size;
+      call(nullptr, &size, &n);
+      return size;
+    }
+
     template <std::output_iterator<const Char&> Out>
     Out format_to(Out out, const std::size_t n = line_formatter_npos) {
-      erased_output<Char> erased(out);
-      call(nullptr, nullptr, &n, &erased);
-      out = rich::out<Out>(erased);
+      // NOTE: A nested cell writes through the erased output of its parent,
+      //       which would otherwise be copied instead of wrapped.
+      if constexpr (std::same_as<Out, erased_output<Char>>) {
+        call(nullptr, nullptr, &n, &out);
+      } else {
+        erased_output<Char> erased(std::ref(out));
+        call(nullptr, nullptr, &n, &erased);
+      }
       return out;
     }
   };
@@ -86,6 +119,10 @@ public:
     return cell_.formatted_size();
   }
 
+  std::size_t formatted_size(const std::size_t n) const {
+    return cell_.formatted_size(n);
+  }
+
   template <std::output_iterator<const Char&> Out>
   Out format_to(Out out, const std::size_t n = line_formatter_npos) {
     return cell_.format_to(out, n);
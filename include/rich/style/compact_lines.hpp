@@ -0,0 +1,204 @@
+/// @file compact_lines.hpp
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <memory>          // std::allocator_arg_t
+#include <memory_resource> // std::pmr::polymorphic_allocator
+#include <ranges>          // std::views::iota, std::views::transform
+#include <string_view>
+#include <vector>
+
+#include <rich/exception.hpp>
+#include <rich/format.hpp> // rich::style_equal
+#include <rich/style/lines.hpp>
+
+namespace rich {
+  /// compact_lines
+  /// Lines stored as parallel arrays: the text of each segment is a 32-bit
+  /// offset and length into a shared buffer and its style is a 16-bit index
+  /// into a table of interned styles. Renders like `lines`.
+  /// NOTE: The buffer is not owned and must outlive `*this`.
+  template <typename Char = char>
+  struct compact_lines {
+    using char_type = Char;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+    using offset_type = std::uint32_t;
+    using style_id = std::uint16_t;
+
+  private:
+    std::basic_string_view<Char> buffer_{};
+    // segment
+    std::pmr::vector<offset_type> offsets_{};
+    std::pmr::vector<offset_type> lengths_{};
+    std::pmr::vector<style_id> style_ids_{};
+    // intern table
+    std::pmr::vector<fmt::text_style> styles_{};
+    // line
+    std::pmr::vector<offset_type> bounds_{};
+    std::pmr::vector<offset_type> widths_{};
+    std::size_t max_width_ = 0;
+    mutable detail::wrap_cache wrap_cache_{};
+
+    style_id intern(const fmt::text_style& style) {
+      // 直前と同じスタイルが続くことが多い
+      if (not style_ids_.empty()
+          and style_equal(styles_[style_ids_.back()], style))
+        return style_ids_.back();
+      for (std::size_t i = 0; i < styles_.size(); ++i)
+        if (style_equal(styles_[i], style))
+          return icast<style_id>(i);
+      if (styles_.size() > std::numeric_limits<style_id>::max())
+        throw runtime_error("Too many styles for `compact_lines`");
+      styles_.push_back(style);
+      return icast<style_id>(styles_.size() - 1);
+    }
+
+    static offset_type narrow(const std::size_t n) {
+      if (n > std::numeric_limits<offset_type>::max())
+        throw runtime_error("Buffer too large for `compact_lines`");
+      return icast<offset_type>(n);
+    }
+
+    void push_back(const segment<Char>& seg) {
+      const auto text = seg.text();
+      if (text.empty()) {
+        offsets_.push_back(0);
+        lengths_.push_back(0);
+        style_ids_.push_back(intern(seg.style()));
+        return;
+      }
+      if (text.data() < buffer_.data()
+          or text.data() + text.size() > buffer_.data() + buffer_.size())
+        throw runtime_error("Segment outside the buffer of `compact_lines`");
+      offsets_.push_back(narrow(icast<std::size_t>(
+        std::ranges::distance(buffer_.data(), text.data()))));
+      lengths_.push_back(narrow(text.size()));
+      style_ids_.push_back(intern(seg.style()));
+    }
+
+    // split_newline に渡す出力イテレータ
+    struct inserter {
+      using difference_type = std::ptrdiff_t;
+      compact_lines* ptr;
+      inserter& operator*() { return *this; }
+      inserter& operator++() { return *this; }
+      inserter operator++(int) { return *this; }
+      const inserter& operator=(const segment<Char>& seg) const {
+        ptr->push_back(seg);
+        return *this;
+      }
+    };
+
+    // 幅と行の境界を 32 bit に詰めて受け取る
+    template <class T>
+    struct narrowing_inserter {
+      using difference_type = std::ptrdiff_t;
+      std::pmr::vector<offset_type>* ptr;
+      narrowing_inserter& operator*() { return *this; }
+      narrowing_inserter& operator++() { return *this; }
+      narrowing_inserter operator++(int) { return *this; }
+      const narrowing_inserter& operator=(const T n) const {
+        ptr->push_back(narrow(icast<std::size_t>(n)));
+        return *this;
+      }
+    };
+
+  public:
+    bool wrap = false;
+
+    // ctor
+    compact_lines() = default;
+
+    /// Stores `segs`, whose texts must lie in `buffer`.
+    template <line_range R>
+    compact_lines(std::basic_string_view<Char> buffer, R&& segs)
+      : compact_lines(std::allocator_arg, {}, buffer, std::forward<R>(segs)) {}
+
+    /// Stores `l`, whose texts must lie in `buffer`.
+    compact_lines(std::basic_string_view<Char> buffer, const lines<Char>& l)
+      : compact_lines(std::allocator_arg, {}, buffer, l) {}
+
+    // allocator-extended ctor
+    template <line_range R>
+    compact_lines(std::allocator_arg_t, const allocator_type& alloc,
+                  std::basic_string_view<Char> buffer, R&& segs)
+      : buffer_(buffer), offsets_(alloc), lengths_(alloc), style_ids_(alloc),
+        styles_(alloc), bounds_(alloc), widths_(alloc) {
+      split_newline(inserter{this},
+                    narrowing_inserter<std::ptrdiff_t>{&bounds_},
+                    narrowing_inserter<std::size_t>{&widths_}, segs);
+      offsets_.shrink_to_fit();
+      lengths_.shrink_to_fit();
+      style_ids_.shrink_to_fit();
+      // NOTE: algorithmはincludeしない方針
+      for (const auto w : widths_)
+        if (w > max_width_)
+          max_width_ = w;
+    }
+
+    compact_lines(std::allocator_arg_t, const allocator_type& alloc,
+                  std::basic_string_view<Char> buffer, const lines<Char>& l)
+      : buffer_(buffer), offsets_(alloc), lengths_(alloc), style_ids_(alloc),
+        styles_(alloc), bounds_(alloc), widths_(alloc),
+        max_width_(l.max_width()), wrap(l.wrap) {
+      bounds_.reserve(l.size() + 1);
+      widths_.reserve(l.size());
+      bounds_.push_back(0);
+      for (std::size_t n = 0; n < l.size(); ++n) {
+        for (const auto& seg : l[n])
+          push_back(seg);
+        bounds_.push_back(narrow(offsets_.size()));
+        widths_.push_back(narrow(l.line_width(n)));
+      }
+    }
+
+    allocator_type get_allocator() const { return offsets_.get_allocator(); }
+
+    // observer
+    auto empty() const { return size() == 0; }
+    std::size_t size() const {
+      return bounds_.empty() ? 0 : std::ranges::size(bounds_) - 1;
+    }
+
+    /// @return number of interned styles
+    std::size_t style_count() const { return styles_.size(); }
+
+    /// @return `n`-th segment
+    segment<Char> segment_at(const std::size_t n) const {
+      return {buffer_.substr(offsets_[n], lengths_[n]),
+              styles_[style_ids_[n]]};
+    }
+
+    /// @return segments of the `n`-th line
+    auto operator[](const std::size_t n) const {
+      assert(n < size());
+      return std::views::iota(std::size_t{bounds_[n]},
+                              std::size_t{bounds_[n + 1]})
+             | std::views::transform(
+               [this](const std::size_t i) { return segment_at(i); });
+    }
+
+    /// @return width of the `n`-th line in O(1)
+    std::size_t line_width(const std::size_t n) const { return widths_[n]; }
+
+    /// @return width of the widest line in O(1)
+    std::size_t max_width() const { return max_width_; }
+
+    /// @return rows of every line wrapped to `width`, cached per width
+    std::shared_ptr<const wrap_layout> layout(const std::size_t width) const {
+      return wrap_cache_.get(*this, width);
+    }
+  };
+} // namespace rich
+
+template <typename Char>
+struct rich::line_formatter<rich::compact_lines<Char>, Char>
+  : rich::detail::lines_formatter<rich::compact_lines<Char>, Char> {
+  using rich::detail::lines_formatter<rich::compact_lines<Char>,
+                                      Char>::lines_formatter;
+};
+
+template <typename Char>
+struct fmt::formatter<rich::compact_lines<Char>, Char>
+  : rich::line_formattable_default_formatter<rich::compact_lines<Char>, Char> {
+};
@@ -1,5 +1,9 @@
 /// @file enumerate.hpp
 #pragma once
+#include <array>
+#include <limits> // std::numeric_limits
+#include <string_view>
+
 #include <rich/format.hpp>
 #include <rich/math.hpp>
 #include <rich/style/format_spec.hpp>
@@ -14,6 +18,9 @@ namespace rich {
     L contents{};
     std::size_t start_line = 1;
     std::size_t end_line = start_line;
+    // lines numbered in [visible_first, visible_last) are shown
+    std::size_t visible_first = 0;
+    std::size_t visible_last = line_formatter_npos;
     fmt::text_style number_highlight_style = {};
     format_spec<char_type> number_spec{
       .style = fmt::emphasis::faint,
@@ -39,6 +46,44 @@ namespace rich {
   template <line_range R>
   enumerate(R&&, int = {})
     -> enumerate<lines<typename std::ranges::range_value_t<R>::char_type>>;
+
+  /// decimal_counter
+  /// Holds the decimal representation of a counter, which is incremented in
+  /// place without division.
+  template <typename Char>
+  struct decimal_counter {
+  private:
+    static constexpr std::size_t capacity =
+      std::numeric_limits<std::size_t>::digits10 + 1;
+    std::array<Char, capacity> buf_{};
+    // digits are stored in [first_, capacity)
+    std::size_t first_ = capacity;
+
+  public:
+    constexpr explicit decimal_counter(std::size_t n = 0) noexcept {
+      do {
+        buf_[--first_] = static_cast<Char>('0' + n % 10);
+        n /= 10;
+      } while (n != 0);
+    }
+
+    constexpr decimal_counter& operator++() noexcept {
+      for (auto i = capacity; i-- > first_;) {
+        if (buf_[i] != Char('9')) {
+          ++buf_[i];
+          return *this;
+        }
+        buf_[i] = Char('0');
+      }
+      assert(first_ > 0);
+      buf_[--first_] = Char('1');
+      return *this;
+    }
+
+    constexpr std::basic_string_view<Char> view() const noexcept {
+      return {buf_.data() + first_, capacity - first_};
+    }
+  };
 } // namespace rich
 
 template <rich::line_formattable L, std::same_as<typename L::char_type> Char>
@@ -46,27 +91,44 @@ struct rich::line_formatter<rich::enumerate<L>, Char> {
 private:
   const rich::enumerate<L>* ptr_ = nullptr;
   std::size_t current_ = 1;
+  decimal_counter<Char> number_{1};
   std::size_t number_width_ = 0;
   line_formatter<L, Char> line_fmtr_;
 
+  // 行番号の列の幅
+  constexpr std::size_t prefix_width() const {
+    return ptr_->highlight_spec.width + number_width_ + 1;
+  }
+
 public:
   explicit line_formatter(const rich::enumerate<L>& l)
-    : ptr_(std::addressof(l)), current_(l.start_line), number_width_([&l] {
+    : ptr_(std::addressof(l)),
+      current_(std::max(l.start_line, l.visible_first)), number_(current_),
+      number_width_([&l] {
         std::size_t w = std::max(l.start_line, l.end_line);
         w = ilog10(w) + 1;
         return std::max(w, l.number_spec.width);
       }()),
-      line_fmtr_(l.contents) {}
+      line_fmtr_(l.contents) {
+    skip_lines(line_fmtr_, current_ - l.start_line);
+  }
 
   constexpr explicit operator bool() const {
-    return ptr_ != nullptr and line_fmtr_;
+    // 折り返した行の続きは visible_last を越えても出力する
+    return ptr_ != nullptr and line_fmtr_
+           and (current_ < ptr_->visible_last or line_continues(line_fmtr_));
   }
 
   constexpr std::size_t formatted_size() const {
     assert(ptr_ != nullptr);
-    const auto highlight_width = ptr_->highlight_spec.width;
-    return sat_add(highlight_width + number_width_ + 1,
-                   line_fmtr_.formatted_size());
+    return sat_add(prefix_width(), line_fmtr_.formatted_size());
+  }
+
+  /// @return width of the next line when formatted to `n` columns
+  std::size_t formatted_size(const std::size_t n) const {
+    assert(ptr_ != nullptr);
+    const auto w = prefix_width();
+    return sat_add(w, line_formatted_size(line_fmtr_, npos_sub(n, w)));
   }
 
   template <std::output_iterator<const Char&> Out>
@@ -74,19 +136,30 @@ public:
     assert(ptr_ != nullptr);
     const auto& ns = ptr_->number_spec;
     const auto& hs = ptr_->highlight_spec;
-    const auto contents_width = npos_sub(n, hs.width + number_width_ + 1);
-    const auto current = current_++;
+    const auto contents_width = npos_sub(n, prefix_width());
     // clang-format off
+    if (line_continues(line_fmtr_)) {
+      // 折り返した行の続きには行番号を付けない
+      out = spec_format_to<Char>(out, hs, "");
+      out = line_format_to<Char>(out, ns.style, std::basic_string_view<Char>(), ns.fill, ns.align, number_width_);
+      instrument::add_padding(1);
+      *out++ = ' ';
+      return counted_format_to(out, line_fmtr_, contents_width);
+    }
+    const auto current = current_++;
+    const auto number = number_.view();
     if (current == ptr_->highlight_line){
       const auto& c = ptr_->highlight_char;
       out = aligned_format_to<Char>(out, ptr_->highlight_style, c, hs.fill, hs.align, npos_sub(hs.width, not c.empty()));
-      out = line_format_to<Char>(out, ptr_->number_highlight_style, current, ns.fill, ns.align, number_width_);
+      out = line_format_to<Char>(out, ptr_->number_highlight_style, number, ns.fill, ns.align, number_width_);
     } else {
       out = spec_format_to<Char>(out, hs, "");
-      out = line_format_to<Char>(out, ns.style, current, ns.fill, ns.align, number_width_);
+      out = line_format_to<Char>(out, ns.style, number, ns.fill, ns.align, number_width_);
     }
+    ++number_;
+    instrument::add_padding(1);
     *out++ = ' ';
-    out = line_fmtr_.format_to(out, contents_width);
+    out = counted_format_to(out, line_fmtr_, contents_width);
     // clang-format on
     return out;
   }
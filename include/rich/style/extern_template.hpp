@@ -0,0 +1,86 @@
+/// @file extern_template.hpp
+#pragma once
+#include <fmt/format.h>
+
+#include <rich/instrument.hpp> // RICH_INSTRUMENT
+#include <rich/iterator.hpp>   // rich::erased_output
+#include <rich/style/cell.hpp>
+#include <rich/style/enumerate.hpp>
+#include <rich/style/line_formatter.hpp>
+#include <rich/style/lines.hpp>
+#include <rich/style/panel.hpp>
+#include <rich/style/table.hpp>
+#include <rich/trace.hpp> // RICH_TRACE
+
+// RICH_SEPARATE_COMPILATION
+// Defined to 1 by the Iris::rich target. The `char` instantiations below are
+// then compiled once in src/rich.cpp instead of in every translation unit.
+#ifndef RICH_SEPARATE_COMPILATION
+#define RICH_SEPARATE_COMPILATION 0
+#endif
+
+// RICH_EXTERN_TEMPLATE
+// `extern template` to declare the instantiations, `template` to define them.
+#ifndef RICH_EXTERN_TEMPLATE
+#define RICH_EXTERN_TEMPLATE extern template
+#endif
+
+// RICH_COMPILED_INSTRUMENT, RICH_COMPILED_TRACE
+// Defined by the Iris::rich target to the values it is compiled with. The
+// hooks of the precompiled instantiations would not match a translation unit
+// defining RICH_INSTRUMENT or RICH_TRACE differently, so that is rejected.
+// Use the IRIS_INSTRUMENT and IRIS_TRACE options instead.
+#if RICH_SEPARATE_COMPILATION
+#if defined(RICH_COMPILED_INSTRUMENT) \
+  and RICH_COMPILED_INSTRUMENT != RICH_INSTRUMENT
+#error "RICH_INSTRUMENT differs from Iris::rich; set IRIS_INSTRUMENT instead"
+#endif
+#if defined(RICH_COMPILED_TRACE) and RICH_COMPILED_TRACE != RICH_TRACE
+#error "RICH_TRACE differs from Iris::rich; set IRIS_TRACE instead"
+#endif
+#endif
+
+#if RICH_SEPARATE_COMPILATION
+// clang-format off
+// lines
+RICH_EXTERN_TEMPLATE struct rich::lines<char>;
+RICH_EXTERN_TEMPLATE struct rich::detail::lines_formatter<rich::lines<char>, char>;
+RICH_EXTERN_TEMPLATE fmt::appender rich::detail::lines_formatter<rich::lines<char>, char>::format_to(fmt::appender, std::size_t);
+RICH_EXTERN_TEMPLATE rich::erased_output<char> rich::detail::lines_formatter<rich::lines<char>, char>::format_to(rich::erased_output<char>, std::size_t);
+RICH_EXTERN_TEMPLATE fmt::appender rich::line_formattable_format_to(fmt::appender, const rich::lines<char>&, std::size_t);
+RICH_EXTERN_TEMPLATE struct rich::line_formattable_default_formatter<rich::lines<char>, char>;
+RICH_EXTERN_TEMPLATE fmt::appender rich::line_formattable_default_formatter<rich::lines<char>, char>::format(const rich::lines<char>&, fmt::format_context&) const;
+
+// enumerate
+RICH_EXTERN_TEMPLATE struct rich::enumerate<rich::lines<char>>;
+RICH_EXTERN_TEMPLATE struct rich::line_formatter<rich::enumerate<rich::lines<char>>, char>;
+RICH_EXTERN_TEMPLATE fmt::appender rich::line_formatter<rich::enumerate<rich::lines<char>>, char>::format_to(fmt::appender, std::size_t);
+RICH_EXTERN_TEMPLATE rich::erased_output<char> rich::line_formatter<rich::enumerate<rich::lines<char>>, char>::format_to(rich::erased_output<char>, std::size_t);
+RICH_EXTERN_TEMPLATE fmt::appender rich::line_formattable_format_to(fmt::appender, const rich::enumerate<rich::lines<char>>&, std::size_t);
+RICH_EXTERN_TEMPLATE struct rich::line_formattable_default_formatter<rich::enumerate<rich::lines<char>>, char>;
+RICH_EXTERN_TEMPLATE fmt::appender rich::line_formattable_default_formatter<rich::enumerate<rich::lines<char>>, char>::format(const rich::enumerate<rich::lines<char>>&, fmt::format_context&) const;
+
+// panel
+RICH_EXTERN_TEMPLATE struct rich::panel<rich::lines<char>>;
+RICH_EXTERN_TEMPLATE struct rich::line_formatter<rich::panel<rich::lines<char>>, char>;
+RICH_EXTERN_TEMPLATE fmt::appender rich::line_formatter<rich::panel<rich::lines<char>>, char>::format_to(fmt::appender, std::size_t);
+RICH_EXTERN_TEMPLATE rich::erased_output<char> rich::line_formatter<rich::panel<rich::lines<char>>, char>::format_to(rich::erased_output<char>, std::size_t);
+RICH_EXTERN_TEMPLATE fmt::appender rich::line_formattable_format_to(fmt::appender, const rich::panel<rich::lines<char>>&, std::size_t);
+RICH_EXTERN_TEMPLATE struct rich::line_formattable_default_formatter<rich::panel<rich::lines<char>>, char>;
+RICH_EXTERN_TEMPLATE fmt::appender rich::line_formattable_default_formatter<rich::panel<rich::lines<char>>, char>::format(const rich::panel<rich::lines<char>>&, fmt::format_context&) const;
+
+// cell
+RICH_EXTERN_TEMPLATE struct rich::cell<char>;
+RICH_EXTERN_TEMPLATE fmt::appender rich::cell<char>::format_to(fmt::appender, std::size_t);
+RICH_EXTERN_TEMPLATE rich::erased_output<char> rich::cell<char>::format_to(rich::erased_output<char>, std::size_t);
+RICH_EXTERN_TEMPLATE struct rich::line_formatter<rich::cell<char>, char>;
+
+// table
+RICH_EXTERN_TEMPLATE struct rich::table<char>;
+RICH_EXTERN_TEMPLATE struct rich::line_formatter<rich::table<char>, char>;
+RICH_EXTERN_TEMPLATE fmt::appender rich::line_formatter<rich::table<char>, char>::format_to(fmt::appender, std::size_t);
+RICH_EXTERN_TEMPLATE fmt::appender rich::line_formattable_format_to(fmt::appender, const rich::table<char>&, std::size_t);
+RICH_EXTERN_TEMPLATE struct rich::line_formattable_default_formatter<rich::table<char>, char>;
+RICH_EXTERN_TEMPLATE fmt::appender rich::line_formattable_default_formatter<rich::table<char>, char>::format(const rich::table<char>&, fmt::format_context&) const;
+// clang-format on
+#endif
@@ -0,0 +1,255 @@
+/// @file hexdump.hpp
+#pragma once
+#include <array>
+#include <bit>     // std::endian
+#include <cstddef> // std::byte
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <fmt/format.h>
+
+#include <rich/format.hpp>
+#include <rich/math.hpp>
+#include <rich/style/line_formatter.hpp>
+
+namespace rich {
+  /// hexdump
+  /// Shows bytes like `hexdump -C`: an offset column, the bytes in hex split
+  /// into groups and an ASCII gutter. Bytes are styled by whether they are
+  /// zero, printable or control bytes.
+  /// Each line is converted when it is formatted, so streaming a large buffer
+  /// with `line_formattable_format_to` only needs memory for one line.
+  /// NOTE: The bytes are not owned and must outlive the line_formatter.
+  template <typename Char = char>
+  struct hexdump {
+    using char_type = Char;
+    std::span<const std::byte> data{};
+    // offset shown for data[0]
+    std::size_t start_offset = 0;
+    std::size_t bytes_per_line = 16;
+    // an extra space is put between groups; 0 for no groups
+    std::size_t group_size = 8;
+    bool ascii = true;
+    fmt::text_style offset_style = fmt::emphasis::faint;
+    fmt::text_style zero_style = fmt::emphasis::faint;
+    fmt::text_style printable_style = {};
+    fmt::text_style control_style = fg(fmt::terminal_color::yellow);
+
+    hexdump() = default;
+    constexpr explicit hexdump(std::span<const std::byte> d) : data(d) {}
+    template <std::ranges::contiguous_range R>
+    requires(sizeof(std::ranges::range_value_t<R>) == 1
+             and std::is_trivially_copyable_v<std::ranges::range_value_t<R>>)
+    constexpr explicit hexdump(R&& r)
+      : data(std::as_bytes(std::span(std::ranges::data(r),
+                                     std::ranges::size(r)))) {}
+
+    /// @return number of lines
+    constexpr std::size_t size() const noexcept {
+      if (bytes_per_line == 0)
+        return 0;
+      return (data.size() + bytes_per_line - 1) / bytes_per_line;
+    }
+  };
+
+  namespace detail {
+    inline constexpr std::string_view hex_digits = "0123456789abcdef";
+
+    enum class byte_class : unsigned char { zero, printable, control };
+
+    constexpr byte_class classify(const std::byte b) noexcept {
+      const auto u = std::to_integer<unsigned>(b);
+      if (u == 0)
+        return byte_class::zero;
+      return 0x20 <= u and u < 0x7f ? byte_class::printable
+                                    : byte_class::control;
+    }
+
+    // 各 byte が 0-15 の 8 つの nibble を '0'-'9', 'a'-'f' にする
+    constexpr std::uint64_t nibbles_to_hex(const std::uint64_t v) noexcept {
+      constexpr std::uint64_t ones = 0x0101010101010101;
+      // 10 以上の nibble の byte だけ 1 になる。繰り上がりは起きない
+      const auto letters = ((v + 6 * ones) >> 4) & ones;
+      return v + '0' * ones + letters * ('a' - '0' - 10);
+    }
+
+    /// Writes "xx " for each of the `n` bytes at `p` to `out`, which has room
+    /// for `3 * n` characters. Eight bytes are converted at a time in a
+    /// 64-bit word.
+    template <typename Char>
+    Char* hex_triplets(Char* out, const std::byte* p, std::size_t n) noexcept {
+      constexpr std::uint64_t low = 0x0f0f0f0f0f0f0f0f;
+      constexpr bool little = std::endian::native == std::endian::little;
+      for (; n >= 8; n -= 8, p += 8) {
+        std::uint64_t v = 0;
+        std::memcpy(&v, p, 8);
+        const auto hi = nibbles_to_hex((v >> 4) & low);
+        const auto lo = nibbles_to_hex(v & low);
+        for (unsigned i = 0; i < 8; ++i) {
+          const unsigned shift = little ? 8 * i : 56 - 8 * i;
+          *out++ = static_cast<Char>((hi >> shift) & 0xff);
+          *out++ = static_cast<Char>((lo >> shift) & 0xff);
+          *out++ = Char(' ');
+        }
+      }
+      for (; n != 0; --n, ++p) {
+        const auto u = std::to_integer<unsigned>(*p);
+        *out++ = static_cast<Char>(hex_digits[u >> 4]);
+        *out++ = static_cast<Char>(hex_digits[u & 0xf]);
+        *out++ = Char(' ');
+      }
+      return out;
+    }
+
+    /// Writes each of the `n` bytes at `p` to `out`, with '.' for the bytes
+    /// which are not printable.
+    template <typename Char>
+    Char* ascii_gutter(Char* out, const std::byte* p, std::size_t n) noexcept {
+      for (; n != 0; --n, ++p) {
+        const auto u = std::to_integer<unsigned>(*p);
+        *out++ = 0x20 <= u and u < 0x7f ? static_cast<Char>(u) : Char('.');
+      }
+      return out;
+    }
+  } // namespace detail
+} // namespace rich
+
+template <typename Char>
+struct rich::line_formatter<rich::hexdump<Char>, Char> {
+private:
+  const rich::hexdump<Char>* ptr_ = nullptr;
+  std::size_t current_ = 0;
+  std::size_t offset_width_ = 8;
+
+  // 最後の行まで埋めたときの hex の列の幅
+  constexpr std::size_t hex_width() const {
+    const auto b = ptr_->bytes_per_line;
+    const auto g = ptr_->group_size;
+    return 3 * b - 1 + (g == 0 ? 0 : (b - 1) / g);
+  }
+
+  constexpr std::span<const std::byte> line_bytes() const {
+    const auto first = current_ * ptr_->bytes_per_line;
+    const auto rest = ptr_->data.size() - first;
+    const auto b = ptr_->bytes_per_line;
+    return ptr_->data.subspan(first, rest < b ? rest : b);
+  }
+
+public:
+  explicit line_formatter(const rich::hexdump<Char>& h)
+    : ptr_(std::addressof(h)), offset_width_([&h] {
+        const auto lines = h.size();
+        auto last = h.start_offset
+                    + (lines == 0 ? 0 : (lines - 1) * h.bytes_per_line);
+        std::size_t w = 0;
+        do {
+          ++w;
+          last >>= 4;
+        } while (last != 0);
+        return w < 8 ? std::size_t(8) : w;
+      }()) {}
+
+  constexpr explicit operator bool() const {
+    return ptr_ != nullptr and current_ < ptr_->size();
+  }
+
+  constexpr std::size_t formatted_size() const {
+    assert(ptr_ != nullptr);
+    const auto ascii_width = ptr_->ascii ? 4 + line_bytes().size() : 0;
+    return offset_width_ + 2 + hex_width() + ascii_width;
+  }
+
+  constexpr void skip(const std::size_t n = 1) {
+    assert(ptr_ != nullptr);
+    const auto rest = ptr_->size() - current_;
+    current_ += n < rest ? n : rest;
+  }
+
+  template <std::output_iterator<const Char&> Out>
+  Out format_to(Out out, const std::size_t n = line_formatter_npos) {
+    assert(ptr_ != nullptr);
+    const auto& h = *ptr_;
+    const auto bytes = line_bytes();
+    const auto k = bytes.size();
+    const auto g = h.group_size;
+    const auto offset = h.start_offset + current_ * h.bytes_per_line;
+    ++current_;
+
+    // この行の分だけ変換する
+    fmt::basic_memory_buffer<Char, 256> buf;
+    buf.resize(4 * k);
+    detail::hex_triplets(buf.data(), bytes.data(), k);
+    detail::ascii_gutter(buf.data() + 3 * k, bytes.data(), k);
+    std::array<Char, 2 * sizeof(std::size_t)> digits{};
+    auto o = offset;
+    for (auto i = offset_width_; i-- > 0; o >>= 4)
+      digits[i] = static_cast<Char>(detail::hex_digits[o & 0xf]);
+
+    // n を超える分は切り捨てる
+    auto rest = n;
+    auto put = [&](std::basic_string_view<Char> sv,
+                   const fmt::text_style* style) {
+      if (rest != line_formatter_npos) {
+        sv = sv.substr(0, rest);
+        rest -= sv.size();
+      }
+      if (sv.empty())
+        return;
+      if (style != nullptr) {
+        out = padded_format_to<Char>(out, *style, sv, {}, 0, 0);
+      } else {
+        instrument::add_text(sv.size());
+        out = copy_to<Char>(out, sv);
+      }
+    };
+    auto pad = [&](std::size_t m) {
+      if (rest != line_formatter_npos) {
+        m = m < rest ? m : rest;
+        rest -= m;
+      }
+      instrument::add_padding(m);
+      out = fill_to<Char>(out, RICH_TYPED_LITERAL(Char, " "), m);
+    };
+    const fmt::text_style* styles[] = {&h.zero_style, &h.printable_style,
+                                       &h.control_style};
+    auto style_of = [&](const std::size_t i) {
+      return styles[static_cast<std::size_t>(detail::classify(bytes[i]))];
+    };
+
+    put({digits.data(), offset_width_}, &h.offset_style);
+    pad(2);
+    // 同じ種類の byte が group の中で続く間は一度に書く
+    for (std::size_t i = 0; i < k;) {
+      if (i != 0)
+        pad(g != 0 and i % g == 0 ? 2 : 1);
+      const auto style = style_of(i);
+      auto j = i + 1;
+      while (j < k and (g == 0 or j % g != 0) and style_of(j) == style)
+        ++j;
+      put({buf.data() + 3 * i, 3 * (j - i) - 1}, style);
+      i = j;
+    }
+    const auto used = 3 * k - 1 + (g == 0 ? 0 : (k - 1) / g);
+    pad(hex_width() - used + (h.ascii ? 2 : 0));
+    if (not h.ascii)
+      return out;
+    put(RICH_TYPED_LITERAL(Char, "|"), nullptr);
+    for (std::size_t i = 0; i < k;) {
+      const auto style = style_of(i);
+      auto j = i + 1;
+      while (j < k and style_of(j) == style)
+        ++j;
+      put({buf.data() + 3 * k + i, j - i}, style);
+      i = j;
+    }
+    put(RICH_TYPED_LITERAL(Char, "|"), nullptr);
+    return out;
+  }
+};
+
+template <typename Char>
+struct fmt::formatter<rich::hexdump<Char>, Char>
+  : rich::line_formattable_default_formatter<rich::hexdump<Char>, Char> {};
@@ -1,7 +1,12 @@
 /// @file line_formatter.hpp
 #pragma once
+#include <string>
+
 #include <rich/format.hpp>
+#include <rich/instrument.hpp>
+#include <rich/iterator.hpp> // rich::counting_output, rich::null_output
 #include <rich/math.hpp>
+#include <rich/trace.hpp>
 
 namespace rich {
 
@@ -38,6 +43,63 @@ namespace rich {
   template <class T>
   concept line_formattable = line_formattable_impl<std::remove_cvref_t<T>>;
 
+  inline constexpr auto line_formatter_npos = std::size_t(-1);
+
+  // counted_format_to
+
+  /// Renders the next line of `line_fmtr`, counted as a line of `L` by
+  /// rich/instrument.hpp and traced by rich/trace.hpp if enabled.
+  template <class L, typename Char, class Out>
+  Out counted_format_to(Out out, line_formatter<L, Char>& line_fmtr,
+                        const std::size_t n = line_formatter_npos) {
+    [[maybe_unused]] const instrument::scope<L> s;
+    [[maybe_unused]] const trace::typed_scope<L> ts("line");
+    return line_fmtr.format_to(out, n);
+  }
+
+  // line_formattable_format_to
+
+  template <line_formattable L,
+            std::output_iterator<const typename L::char_type&> Out>
+  Out line_formattable_format_to(Out out, const L& l,
+                                 const std::size_t n = line_formatter_npos) {
+    using Char = typename L::char_type;
+    [[maybe_unused]] const trace::typed_scope<L> ts("write");
+    Char dlm = '\0';
+    for (line_formatter<L, Char> line_fmtr(l); bool(line_fmtr);) {
+      *out++ = std::exchange(dlm, '\n');
+      out = counted_format_to(out, line_fmtr, n);
+    }
+    return out;
+  }
+
+  // formatted_size
+
+  /// @return the exact number of code units `l` is rendered to
+  /// NOTE: `l` is rendered to a counting_output, which is recorded as one
+  ///       "measure" trace event and is not counted by the instrument.
+  template <line_formattable L>
+  std::size_t formatted_size(const L& l,
+                             const std::size_t n = line_formatter_npos) {
+    [[maybe_unused]] const trace::scope ts("formatted_size", "measure");
+    [[maybe_unused]] const instrument::pause ip;
+    [[maybe_unused]] const trace::pause tp;
+    return line_formattable_format_to(counting_output{}, l, n).count();
+  }
+
+  // format
+
+  /// Renders `l` into a string allocated once with the exact size.
+  template <line_formattable L>
+  auto format(const L& l, const std::size_t n = line_formatter_npos) {
+    using Char = typename L::char_type;
+    std::basic_string<Char> str(formatted_size(l, n), Char());
+    [[maybe_unused]] const auto last =
+      line_formattable_format_to(str.data(), l, n);
+    assert(last == str.data() + str.size());
+    return str;
+  }
+
   // line_formattable_default_formatter
 
   template <rich::line_formattable L, std::same_as<typename L::char_type> Char>
@@ -49,21 +111,52 @@ namespace rich {
 
     template <typename FormatContext>
     auto format(const L& l, FormatContext& ctx) const -> decltype(ctx.out()) {
-      auto out = ctx.out();
-      char dlm = '\0';
-      for (line_formatter<L, Char> line_fmtr(l); bool(line_fmtr);) {
-        out = fmt::detail::write(out, std::exchange(dlm, '\n'));
-        out = line_fmtr.format_to(out);
-      }
-      return out;
+      return line_formattable_format_to(ctx.out(), l);
     }
   };
 
-  // line_format_to
+  // line_formatted_size
+
+  /// @return width of the next line of `line_fmtr` when formatted to `n`
+  ///         columns, if it provides `formatted_size(n)`, otherwise
+  ///         `formatted_size()`
+  template <class LF>
+  std::size_t line_formatted_size(const LF& line_fmtr, const std::size_t n) {
+    if constexpr (requires { line_fmtr.formatted_size(n); })
+      return line_fmtr.formatted_size(n);
+    else
+      return line_fmtr.formatted_size();
+  }
 
-  inline constexpr auto line_formatter_npos = std::size_t(-1);
+  // line_continues
+
+  /// @return true if the next line of `line_fmtr` is a continuation row of
+  ///         the line formatted last, e.g. a wrapped row, if it provides
+  ///         `continuation()`, otherwise false
+  template <class LF>
+  constexpr bool line_continues(const LF& line_fmtr) {
+    if constexpr (requires { line_fmtr.continuation(); })
+      return line_fmtr.continuation();
+    else
+      return false;
+  }
+
+  // skip_lines
+
+  /// Advances `line_fmtr` by `n` lines without rendering them if it provides
+  /// `skip`, otherwise renders the skipped lines to nowhere.
+  template <class LF>
+  void skip_lines(LF& line_fmtr, std::size_t n) {
+    if constexpr (requires { line_fmtr.skip(n); })
+      line_fmtr.skip(n);
+    else
+      for (; n > 0 and bool(line_fmtr); --n)
+        line_fmtr.format_to(null_output{});
+  }
+
+  // line_format_to
 
-  std::size_t npos_sub(std::size_t x, std::size_t y) noexcept {
+  inline std::size_t npos_sub(std::size_t x, std::size_t y) noexcept {
     if (x == line_formatter_npos) {
       assert(y != line_formatter_npos);
       return x;
@@ -77,12 +170,13 @@ namespace rich {
                      std::basic_string_view<Char> fill, const align_t align,
                      const std::size_t width) {
     if (width == line_formatter_npos)
-      return line_fmtr.format_to(out);
+      return counted_format_to(out, line_fmtr);
 
-    const auto fillwidth = sat_sub(width, line_fmtr.formatted_size());
+    const auto fillwidth =
+      sat_sub(width, line_formatted_size(line_fmtr, width));
     const auto [left, right] = padding_size(align, fillwidth);
     out = padded_format_to<Char>(out, style, "", fill, 0, left);
-    out = line_fmtr.format_to(out, width);
+    out = counted_format_to(out, line_fmtr, width);
     out = padded_format_to<Char>(out, style, "", fill, 0, right);
     return out;
   }
@@ -104,8 +198,12 @@ namespace rich {
   Out line_format_to(Out out, const fmt::text_style& style, const T& t,
                      std::basic_string_view<Char> fill, const align_t align,
                      const std::size_t width) {
-    const auto str = fmt::format("{}", t);
-    return line_format_to(out, style, std::basic_string_view<Char>(str), fill,
-                          align, width);
+    // NOTE: Formatted into the inline storage, which only allocates for
+    //       unusually long results.
+    fmt::basic_memory_buffer<Char, 64> buf;
+    fmt::format_to(std::back_inserter(buf), RICH_TYPED_LITERAL(Char, "{}"), t);
+    return line_format_to(out, style,
+                          std::basic_string_view<Char>(buf.data(), buf.size()),
+                          fill, align, width);
   }
 } // namespace rich
@@ -1,11 +1,15 @@
 /// @file lines.hpp
 #pragma once
-#include <iterator> // std::back_inserter, std::ssize
+#include <atomic>
+#include <iterator>        // std::back_inserter, std::ssize
+#include <memory>          // std::allocator_arg_t, std::shared_ptr
+#include <memory_resource> // std::pmr::polymorphic_allocator
 #include <string_view>
 #include <vector>
 
 #include <rich/format.hpp>
-#include <rich/ranges.hpp> // rich::ranges::index, rich::ranges::accumulate
+#include <rich/iterator.hpp> // rich::null_output
+#include <rich/ranges.hpp>   // rich::ranges::index
 #include <rich/style/line_formatter.hpp>
 #include <rich/style/segment.hpp>
 
@@ -14,36 +18,177 @@ namespace rich {
   concept line_range =
     std::ranges::range<R> and is_segment_v<std::ranges::range_value_t<R>>;
 
-  template <class Out1, std::output_iterator<std::ptrdiff_t> Out2, line_range R>
+  /// Splits `segs` at newlines. The segments of each line are written to
+  /// `out1`, the line boundaries to `out2` and the width of each line to
+  /// `out3`.
+  template <class Out1, std::output_iterator<std::ptrdiff_t> Out2,
+            std::output_iterator<std::size_t> Out3, line_range R>
   requires std::output_iterator<Out1, std::ranges::range_value_t<R>>
-    std::ptrdiff_t split_newline(Out1 out1, Out2 out2, R&& segs) {
+    std::ptrdiff_t split_newline(Out1 out1, Out2 out2, Out3 out3, R&& segs) {
     *out2++ = 0;
     std::ptrdiff_t out1_count = 0;
+    std::size_t width = 0;
     const auto npos = std::basic_string_view<
       typename std::ranges::range_value_t<R>::char_type>::npos;
 
     for (const auto& seg : segs) {
       for (std::size_t current = 0; current < seg.text().size();) {
         auto next = seg.text().find('\n', current);
-        *out1++ = {seg.text().substr(current, next - current), seg.style()};
+        auto text = seg.text().substr(current, next - current);
+        *out1++ = {text, seg.style()};
         ++out1_count;
+        width += text.size();
         if (next == npos)
           break;
         *out2++ = out1_count;
+        *out3++ = std::exchange(width, 0);
         current = next + 1;
       }
     }
 
     *out2++ = out1_count;
+    *out3++ = width;
     return out1_count;
   }
 
+  template <class Out1, std::output_iterator<std::ptrdiff_t> Out2, line_range R>
+  requires std::output_iterator<Out1, std::ranges::range_value_t<R>>
+    std::ptrdiff_t split_newline(Out1 out1, Out2 out2, R&& segs) {
+    return split_newline(std::move(out1), std::move(out2), null_output{},
+                         std::forward<R>(segs));
+  }
+
+  // wrap_line
+
+  /// A row of a wrapped line, given as offsets [first, last) into the line.
+  struct wrap_row {
+    std::size_t first = 0;
+    std::size_t last = 0;
+  };
+
+  /// Breaks `line` into rows no wider than `width` in a single pass. Rows
+  /// are broken at spaces, which are dropped at the break; a word wider than
+  /// `width` is broken anywhere. Writes at least one row to `out`.
+  template <std::output_iterator<const wrap_row&> Out, line_range R>
+  Out wrap_line(Out out, R&& line, const std::size_t width) {
+    assert(width != 0);
+    constexpr auto npos = line_formatter_npos;
+    // start of the current row, npos while skipping spaces after a break
+    std::size_t start = 0;
+    // first space of the last run of spaces in the current row
+    std::size_t space = npos;
+    // first character after that run
+    std::size_t word = npos;
+    std::size_t off = 0;
+    bool prev_space = false;
+    bool emitted = false;
+
+    for (const auto& seg : line) {
+      for (const auto c : seg.text()) {
+        const bool is_space = c == ' ';
+        if (start == npos) {
+          if (is_space) {
+            ++off;
+            continue;
+          }
+          start = off;
+          prev_space = false;
+        }
+        if (is_space and not prev_space and off != start)
+          space = off;
+        if (not is_space and prev_space and space != npos)
+          word = off;
+        if (off - start + 1 > width) {
+          emitted = true;
+          if (is_space and space != npos) {
+            // 空白で溢れた場合は、続く空白を読み飛ばす
+            *out++ = wrap_row{start, space};
+            start = space = word = npos;
+            ++off;
+            continue;
+          } else if (not is_space and word != npos) {
+            *out++ = wrap_row{start, space};
+            start = word;
+          } else {
+            *out++ = wrap_row{start, off};
+            start = off;
+          }
+          space = word = npos;
+        }
+        prev_space = is_space;
+        ++off;
+      }
+    }
+    if (start != npos and (off != start or not emitted))
+      *out++ = wrap_row{start, off};
+    return out;
+  }
+
+  /// wrap_layout
+  /// Rows of every line of `lines` wrapped to `width`.
+  struct wrap_layout {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    std::size_t width = 0;
+    std::pmr::vector<wrap_row> rows{};
+    // index of the first row of each line, followed by `rows.size()`
+    std::pmr::vector<std::size_t> firsts{};
+
+    wrap_layout(std::allocator_arg_t, const allocator_type& alloc,
+                const std::size_t w)
+      : width(w), rows(alloc), firsts(alloc) {}
+  };
+
+  namespace detail {
+    // copyable holder of the most recently used wrap_layout
+    struct wrap_cache {
+      std::atomic<std::shared_ptr<const wrap_layout>> ptr{};
+
+      wrap_cache() = default;
+      wrap_cache(const wrap_cache& x) : ptr(x.ptr.load()) {}
+      wrap_cache& operator=(const wrap_cache& x) {
+        ptr.store(x.ptr.load());
+        return *this;
+      }
+
+      /// @return layout of every line of `l` wrapped to `width`, reusing the
+      ///         cached one if it has the same width
+      template <class L>
+      std::shared_ptr<const wrap_layout> get(const L& l,
+                                             const std::size_t width) {
+        auto cached = ptr.load(std::memory_order_acquire);
+        if (cached != nullptr and cached->width == width)
+          return cached;
+        [[maybe_unused]] const trace::scope ts("wrap_layout", "layout");
+        // NOTE: uses-allocator construction passes the allocator to the rows
+        auto made = std::allocate_shared<wrap_layout>(
+          std::pmr::polymorphic_allocator<wrap_layout>(l.get_allocator()),
+          width);
+        made->firsts.reserve(l.size() + 1);
+        for (std::size_t n = 0; n < l.size(); ++n) {
+          made->firsts.push_back(made->rows.size());
+          wrap_line(std::back_inserter(made->rows), l[n], width);
+        }
+        made->firsts.push_back(made->rows.size());
+        ptr.store(made, std::memory_order_release);
+        return made;
+      }
+    };
+  } // namespace detail
+
+  template <typename Char>
+  struct lines_view;
+
   template <typename Char = char>
   struct lines {
   private:
-    std::vector<segment<Char>> segments_{};
+    std::pmr::vector<segment<Char>> segments_{};
     // default constructed with vecotor of size 1, value 0
-    std::vector<std::ptrdiff_t> bounds_{0};
+    std::pmr::vector<std::ptrdiff_t> bounds_{0};
+    // width of each line, computed in `split_newline`
+    std::pmr::vector<std::size_t> widths_{};
+    std::size_t max_width_ = 0;
+    mutable detail::wrap_cache wrap_cache_{};
 
     struct iterator {
     private:
@@ -54,8 +199,8 @@ namespace rich {
       using value_type = std::span<const segment<Char>>;
       using difference_type = std::ptrdiff_t;
       using reference = value_type;
-      using iterator_category = std::forward_iterator_tag;
-      using iterator_concept = std::forward_iterator_tag;
+      using iterator_category = std::random_access_iterator_tag;
+      using iterator_concept = std::random_access_iterator_tag;
 
       iterator() = default;
       constexpr iterator(const lines& l, const std::ptrdiff_t n)
@@ -65,13 +210,17 @@ namespace rich {
         return parent_ == x.parent_ and current_ == x.current_;
       };
       bool operator!=(const iterator& x) const { return !(*this == x); }
+      auto operator<=>(const iterator& x) const {
+        assert(parent_ == x.parent_);
+        return current_ <=> x.current_;
+      }
 
       reference operator*() const {
         assert(parent_ != nullptr);
-        auto fst = std::ranges::begin(parent_->segments_);
-        return std::span(
-          fst + rich::ranges::index(parent_->bounds_, current_),
-          fst + rich::ranges::index(parent_->bounds_, current_ + 1));
+        return (*parent_)[icast<std::size_t>(current_)];
+      }
+      reference operator[](const difference_type n) const {
+        return *(*this + n);
       }
 
       iterator& operator++() {
@@ -83,45 +232,196 @@ namespace rich {
         ++(*this);
         return t;
       }
+      iterator& operator--() {
+        --current_;
+        return *this;
+      }
+      iterator operator--(int) {
+        iterator t(*this);
+        --(*this);
+        return t;
+      }
+
+      iterator& operator+=(const difference_type n) {
+        current_ += n;
+        return *this;
+      }
+      iterator& operator-=(const difference_type n) {
+        current_ -= n;
+        return *this;
+      }
+      friend iterator operator+(iterator i, const difference_type n) {
+        return i += n;
+      }
+      friend iterator operator+(const difference_type n, iterator i) {
+        return i += n;
+      }
+      friend iterator operator-(iterator i, const difference_type n) {
+        return i -= n;
+      }
+      friend difference_type operator-(const iterator& x, const iterator& y) {
+        assert(x.parent_ == y.parent_);
+        return x.current_ - y.current_;
+      }
     };
 
+    template <line_range R>
+    void init(R&& segs, const std::size_t size_hint, const bool shrink) {
+      [[maybe_unused]] const trace::scope ts("lines", "layout");
+      widths_.reserve(size_hint + 1);
+      split_newline(std::back_inserter(segments_), std::back_inserter(bounds_),
+                    std::back_inserter(widths_), segs);
+      if (shrink) {
+        segments_.shrink_to_fit();
+        bounds_.shrink_to_fit();
+        widths_.shrink_to_fit();
+      }
+      // NOTE: algorithmはincludeしない方針
+      for (const auto w : widths_)
+        if (w > max_width_)
+          max_width_ = w;
+    }
+
   public:
     using char_type = Char;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    // 幅を超える行を切り詰めずに単語の境界で折り返す
+    bool wrap = false;
 
     // ctor
     lines() = default;
 
     // NOTE: implicit conversion is allowed
     template <line_range R>
-    constexpr lines(R&& segs, const std::size_t size_hint = 0)
-      : bounds_(make_reserved<std::vector<std::ptrdiff_t>>(size_hint + 1)) {
+    lines(R&& segs, const std::size_t size_hint = 0)
+      : lines(std::allocator_arg, {}, std::forward<R>(segs), size_hint) {}
+
+    lines(std::initializer_list<segment<Char>> segs,
+          const std::size_t size_hint = 0)
+      : lines(std::allocator_arg, {}, segs, size_hint) {}
+
+    // allocator-extended ctor
+    // NOTE: Every allocation is made through `alloc`. Passing `shrink = false`
+    //       skips `shrink_to_fit`, which only wastes a monotonic resource.
+    template <line_range R>
+    lines(std::allocator_arg_t, const allocator_type& alloc, R&& segs,
+          const std::size_t size_hint = 0, const bool shrink = true)
+      : segments_(alloc),
+        bounds_(make_reserved<std::pmr::vector<std::ptrdiff_t>>(size_hint + 1,
+                                                                alloc)),
+        widths_(alloc) {
       if constexpr (std::ranges::sized_range<R>)
         segments_.reserve(std::ranges::size(segs) + size_hint);
       else
         segments_.reserve(size_hint + 1);
 
-      split_newline(std::back_inserter(segments_), std::back_inserter(bounds_),
-                    segs);
-      segments_.shrink_to_fit();
-      bounds_.shrink_to_fit();
+      init(segs, size_hint, shrink);
     }
 
-    constexpr lines(std::initializer_list<segment<Char>> segs,
-                    const std::size_t size_hint = 0)
-      : bounds_(make_reserved<std::vector<std::ptrdiff_t>>(size_hint + 1)) {
+    lines(std::allocator_arg_t, const allocator_type& alloc,
+          std::initializer_list<segment<Char>> segs,
+          const std::size_t size_hint = 0, const bool shrink = true)
+      : segments_(alloc),
+        bounds_(make_reserved<std::pmr::vector<std::ptrdiff_t>>(size_hint + 1,
+                                                                alloc)),
+        widths_(alloc) {
       segments_.reserve(segs.size() + size_hint);
 
-      split_newline(std::back_inserter(segments_), std::back_inserter(bounds_),
-                    segs);
-      segments_.shrink_to_fit();
-      bounds_.shrink_to_fit();
+      init(segs, size_hint, shrink);
     }
 
+    lines(std::allocator_arg_t, const allocator_type& alloc, const lines& l)
+      : segments_(l.segments_, alloc), bounds_(l.bounds_, alloc),
+        widths_(l.widths_, alloc), max_width_(l.max_width_), wrap(l.wrap) {}
+
+    allocator_type get_allocator() const { return segments_.get_allocator(); }
+
     // observer
     iterator begin() const { return {*this, 0}; }
     iterator end() const { return {*this, std::ssize(bounds_) - 1}; }
     auto empty() const { return std::ranges::size(bounds_) == 1; }
     auto size() const { return std::ranges::size(bounds_) - 1; }
+
+    /// @return segments of the `n`-th line
+    std::span<const segment<Char>> operator[](const std::size_t n) const {
+      assert(n < size());
+      auto fst = std::ranges::begin(segments_);
+      return std::span(fst + rich::ranges::index(bounds_, n),
+                       fst + rich::ranges::index(bounds_, n + 1));
+    }
+
+    /// @return width of the `n`-th line in O(1)
+    std::size_t line_width(const std::size_t n) const {
+      return rich::ranges::index(widths_, n);
+    }
+
+    /// @return width of the widest line in O(1)
+    std::size_t max_width() const { return max_width_; }
+
+    /// @return rows of every line wrapped to `width`. The layout of the most
+    ///         recent width is cached, so rendering again at the same width
+    ///         does not reflow.
+    std::shared_ptr<const wrap_layout> layout(const std::size_t width) const {
+      return wrap_cache_.get(*this, width);
+    }
+
+    /// @return view of lines [first, first + count), clamped to `size()`
+    lines_view<Char> subrange(std::size_t first,
+                              std::size_t count = line_formatter_npos) const {
+      first = first < size() ? first : size();
+      const auto rest = size() - first;
+      return {*this, first, first + (count < rest ? count : rest)};
+    }
+
+    /// @return view of the last `n` lines
+    lines_view<Char> tail(const std::size_t n) const {
+      return subrange(n < size() ? size() - n : 0);
+    }
+  };
+
+  /// lines_view
+  /// A view of consecutive lines of `lines`, which is rendered without
+  /// copying its segments.
+  template <typename Char>
+  struct lines_view : std::ranges::view_interface<lines_view<Char>> {
+  private:
+    const lines<Char>* parent_ = nullptr;
+    std::size_t first_ = 0;
+    std::size_t last_ = 0;
+
+  public:
+    using char_type = Char;
+
+    lines_view() = default;
+    lines_view(const lines<Char>& l, const std::size_t first,
+               const std::size_t last)
+      : parent_(std::addressof(l)), first_(first), last_(last) {
+      assert(first_ <= last_ and last_ <= l.size());
+    }
+
+    auto begin() const {
+      assert(parent_ != nullptr);
+      return std::ranges::begin(*parent_) + icast<std::ptrdiff_t>(first_);
+    }
+    auto end() const {
+      assert(parent_ != nullptr);
+      return std::ranges::begin(*parent_) + icast<std::ptrdiff_t>(last_);
+    }
+    std::size_t size() const { return last_ - first_; }
+
+    const lines<Char>& base() const {
+      assert(parent_ != nullptr);
+      return *parent_;
+    }
+    std::size_t first_index() const { return first_; }
+    std::size_t last_index() const { return last_; }
+
+    /// @return width of the `n`-th line of this view in O(1)
+    std::size_t line_width(const std::size_t n) const {
+      assert(n < size());
+      return base().line_width(first_ + n);
+    }
   };
 
   template <line_range R>
@@ -145,40 +445,140 @@ namespace rich {
   }
 } // namespace rich
 
-template <typename Char>
-struct rich::line_formatter<rich::lines<Char>, Char> {
-private:
-  const lines<Char>* ptr_ = nullptr;
-  std::ranges::iterator_t<lines<Char>> current_{};
+namespace rich::detail {
+  // line_formatter of `lines` and of types with the same interface
+  template <class L, typename Char>
+  struct lines_formatter {
+  private:
+    const L* ptr_ = nullptr;
+    std::size_t current_ = 0;
+    std::size_t last_ = 0;
+    // wrap mode: row of the current line to be formatted next
+    std::size_t row_ = 0;
+    mutable std::shared_ptr<const wrap_layout> layout_{};
 
-public:
-  explicit line_formatter(const lines<Char>& l)
-    : ptr_(std::addressof(l)), current_(std::ranges::begin(l)) {}
+    bool wrapping(const std::size_t n) const {
+      return ptr_->wrap and n != line_formatter_npos and n != 0;
+    }
 
-  constexpr explicit operator bool() const {
-    return ptr_ != nullptr and current_ != std::ranges::end(*ptr_);
-  }
+    const wrap_layout& layout(const std::size_t n) const {
+      if (layout_ == nullptr or layout_->width != n)
+        layout_ = ptr_->layout(n);
+      return *layout_;
+    }
 
-  constexpr std::size_t formatted_size() const {
-    return rich::ranges::accumulate(
-      *current_, icast<std::size_t>(0), {},
-      [](const auto& seg) { return seg.text().size(); });
-  }
+    wrap_row current_row(const std::size_t n) const {
+      const auto& l = layout(n);
+      return l.rows[l.firsts[current_] + row_];
+    }
 
-  template <std::output_iterator<const Char&> Out>
-  Out format_to(Out out, const std::size_t n = line_formatter_npos) {
-    assert(ptr_ != nullptr);
-    auto line = *current_++;
-    if (n == line_formatter_npos)
-      return fmt::format_to(out, "{}", fmt::join(line, ""));
-
-    auto cropped =
-      make_reserved<std::vector<segment<Char>>>(std::ranges::size(line));
-    crop_line(std::back_inserter(cropped), line, n);
-    return fmt::format_to(out, "{}", fmt::join(cropped, ""));
-  }
+  public:
+    explicit lines_formatter(const L& l)
+      : ptr_(std::addressof(l)), last_(std::ranges::size(l)) {}
+
+    /// Formats lines [first, last) of `l`.
+    lines_formatter(const L& l, const std::size_t first, const std::size_t last)
+      : ptr_(std::addressof(l)), current_(first), last_(last) {
+      assert(first <= last and last <= std::ranges::size(l));
+    }
+
+    constexpr explicit operator bool() const {
+      return ptr_ != nullptr and current_ != last_;
+    }
+
+    constexpr std::size_t formatted_size() const {
+      assert(ptr_ != nullptr);
+      const auto width = ptr_->line_width(current_);
+      if (row_ == 0)
+        return width;
+      return width - current_row(layout_->width).first;
+    }
+
+    /// @return width of the next line when formatted to `n` columns
+    std::size_t formatted_size(const std::size_t n) const {
+      assert(ptr_ != nullptr);
+      if (not wrapping(n) or (row_ == 0 and ptr_->line_width(current_) <= n))
+        return formatted_size();
+      const auto row = current_row(n);
+      return row.last - row.first;
+    }
+
+    /// @return true if the next row continues a wrapped line
+    constexpr bool continuation() const { return row_ != 0; }
+
+    /// Advances by `n` lines in O(1). Rows of a wrapped line are not counted.
+    constexpr void skip(const std::size_t n) {
+      assert(ptr_ != nullptr);
+      const auto rest = last_ - current_;
+      current_ += n < rest ? n : rest;
+      row_ = 0;
+    }
+
+    template <std::output_iterator<const Char&> Out>
+    Out format_to(Out out, const std::size_t n = line_formatter_npos) {
+      assert(ptr_ != nullptr);
+      const auto width = ptr_->line_width(current_);
+      if (wrapping(n) and (row_ != 0 or width > n)) {
+        const auto& l = layout(n);
+        const auto row = l.rows[l.firsts[current_] + row_];
+        auto line = (*ptr_)[current_];
+        if (l.firsts[current_] + ++row_ == l.firsts[current_ + 1]) {
+          ++current_;
+          row_ = 0;
+        }
+        // 行のうち [row.first, row.last) に掛かる部分を出力する
+        std::size_t offset = 0;
+        for (const auto& seg : line) {
+          const auto size = seg.text().size();
+          if (offset + size > row.first and offset < row.last) {
+            const auto first = row.first > offset ? row.first - offset : 0;
+            const auto last =
+              row.last - offset < size ? row.last - offset : size;
+            const auto text = seg.text().substr(first, last - first);
+            out = fmt::format_to(out, "{}", segment<Char>(text, seg.style()));
+          }
+          offset += size;
+        }
+        return out;
+      }
+
+      auto line = (*ptr_)[current_++];
+      if (n == line_formatter_npos or width <= n)
+        return fmt::format_to(out, "{}", fmt::join(line, ""));
+
+      // crop_line と同じく切って、vector を介さずに出力する
+      std::size_t offset = 0;
+      for (const auto& seg : line) {
+        const auto text = seg.text().substr(0, n - offset);
+        out = fmt::format_to(out, "{}", segment<Char>(text, seg.style()));
+        offset += seg.text().size();
+        if (offset > n)
+          break;
+      }
+      return out;
+    }
+  };
+} // namespace rich::detail
+
+template <typename Char>
+struct rich::line_formatter<rich::lines<Char>, Char>
+  : rich::detail::lines_formatter<rich::lines<Char>, Char> {
+  using rich::detail::lines_formatter<rich::lines<Char>,
+                                      Char>::lines_formatter;
+};
+
+template <typename Char>
+struct rich::line_formatter<rich::lines_view<Char>, Char>
+  : rich::line_formatter<rich::lines<Char>, Char> {
+  explicit line_formatter(const lines_view<Char>& v)
+    : rich::line_formatter<rich::lines<Char>, Char>(v.base(), v.first_index(),
+                                                    v.last_index()) {}
 };
 
 template <typename Char>
 struct fmt::formatter<rich::lines<Char>, Char>
   : rich::line_formattable_default_formatter<rich::lines<Char>, Char> {};
+
+template <typename Char>
+struct fmt::formatter<rich::lines_view<Char>, Char>
+  : rich::line_formattable_default_formatter<rich::lines_view<Char>, Char> {};
@@ -0,0 +1,534 @@
+/// @file markup.hpp
+#pragma once
+#include <array>
+#include <cstdint>
+#include <iterator> // std::back_inserter
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fmt/format.h>
+#include <fmt/xchar.h> // fmt::vformat_to for any Char
+
+#include <rich/exception.hpp>
+#include <rich/format.hpp>
+#include <rich/style/segment.hpp>
+
+namespace rich {
+  // Markup
+  // - `[style]` opens a style, e.g. `[bold red on white]`, `[#ff8800]`
+  // - `[/]` closes the innermost style, `[/style]` closes it by name
+  // - `\[` and `\\` are a literal `[` and `\`
+  // - `[` not followed by a letter, `#` or `/` is a literal `[`
+  // Styles opened later are combined with the enclosing ones; colors of the
+  // inner style take precedence.
+
+  /// markup_mode
+  /// How malformed markup is handled.
+  /// - strict: an unknown style, an unterminated or unmatched tag and a tag
+  ///   left open at the end are errors reported with their offset
+  /// - lenient: such tags are literal text and open tags are closed at the
+  ///   end, as runtime text like `a[i]` or `see [note]` is shown as is
+  enum class markup_mode : unsigned char { strict, lenient };
+
+  // basic_fixed_string
+
+  template <typename Char, std::size_t N>
+  struct basic_fixed_string {
+    Char data[N]{};
+
+    consteval basic_fixed_string(const Char (&s)[N]) {
+      for (std::size_t i = 0; i < N; ++i)
+        data[i] = s[i];
+    }
+
+    using char_type = Char;
+    constexpr std::basic_string_view<Char> view() const {
+      return {data, N - 1};
+    }
+  };
+
+  // parse_style
+
+  namespace detail {
+    template <typename Char>
+    constexpr bool ascii_equal(std::basic_string_view<Char> x,
+                               std::string_view y) {
+      if (x.size() != y.size())
+        return false;
+      for (std::size_t i = 0; i < x.size(); ++i)
+        if (x[i] != static_cast<Char>(y[i]))
+          return false;
+      return true;
+    }
+
+    template <typename Char>
+    constexpr int hex_digit(const Char c) {
+      if ('0' <= c and c <= '9')
+        return c - '0';
+      if ('a' <= c and c <= 'f')
+        return c - 'a' + 10;
+      if ('A' <= c and c <= 'F')
+        return c - 'A' + 10;
+      return -1;
+    }
+
+    // 色なら前景か背景として style に加える
+    template <typename Char>
+    constexpr bool parse_color(std::basic_string_view<Char> word,
+                               const bool background, fmt::text_style& style) {
+      if (word.size() == 7 and word[0] == '#') {
+        std::uint32_t hex = 0;
+        for (std::size_t i = 1; i < 7; ++i) {
+          const int d = hex_digit(word[i]);
+          if (d < 0)
+            return false;
+          hex = hex * 16 + static_cast<std::uint32_t>(d);
+        }
+        style |= background ? fmt::bg(fmt::rgb(hex)) : fmt::fg(fmt::rgb(hex));
+        return true;
+      }
+      constexpr std::string_view names[] = {
+        "black",        "red",          "green",         "yellow",
+        "blue",         "magenta",      "cyan",          "white",
+        "bright_black", "bright_red",   "bright_green",  "bright_yellow",
+        "bright_blue",  "bright_magenta", "bright_cyan", "bright_white",
+      };
+      using tc = fmt::terminal_color;
+      constexpr tc colors[] = {
+        tc::black,        tc::red,          tc::green,        tc::yellow,
+        tc::blue,         tc::magenta,      tc::cyan,         tc::white,
+        tc::bright_black, tc::bright_red,   tc::bright_green, tc::bright_yellow,
+        tc::bright_blue,  tc::bright_magenta, tc::bright_cyan, tc::bright_white,
+      };
+      for (std::size_t i = 0; i < std::size(names); ++i) {
+        if (ascii_equal(word, names[i])) {
+          style |= background ? fmt::bg(colors[i]) : fmt::fg(colors[i]);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    template <typename Char>
+    constexpr bool parse_emphasis(std::basic_string_view<Char> word,
+                                  std::uint8_t& bits) {
+      constexpr std::string_view names[] = {
+        "bold", "dim",     "italic", "underline",
+        "blink", "reverse", "conceal", "strike",
+      };
+      constexpr fmt::emphasis ems[] = {
+        fmt::emphasis::bold,  fmt::emphasis::faint,
+        fmt::emphasis::italic, fmt::emphasis::underline,
+        fmt::emphasis::blink, fmt::emphasis::reverse,
+        fmt::emphasis::conceal, fmt::emphasis::strikethrough,
+      };
+      for (std::size_t i = 0; i < std::size(names); ++i) {
+        if (ascii_equal(word, names[i])) {
+          bits |= static_cast<std::uint8_t>(ems[i]);
+          return true;
+        }
+      }
+      return false;
+    }
+  } // namespace detail
+
+  namespace detail {
+    /// Parses a style definition into `style`.
+    /// @return error message, or nullptr on success
+    template <typename Char>
+    constexpr const char* parse_style_to(std::basic_string_view<Char> def,
+                                         fmt::text_style& style) {
+      std::uint8_t bits = 0;
+      bool background = false;
+      while (not def.empty()) {
+        const auto space = def.find(Char(' '));
+        const auto word = def.substr(0, space);
+        def = space == def.npos ? def.substr(def.size())
+                                : def.substr(space + 1);
+        if (word.empty())
+          continue;
+        if (ascii_equal(word, "on")) {
+          background = true;
+          continue;
+        }
+        if (parse_color(word, background, style))
+          background = false;
+        else if (background or not parse_emphasis(word, bits))
+          return "Unknown style in markup";
+      }
+      if (background)
+        return "Missing background color in markup";
+      if (bits != 0)
+        style |= fmt::text_style(static_cast<fmt::emphasis>(bits));
+      return nullptr;
+    }
+  } // namespace detail
+
+  /// Parses a space separated style definition, e.g. `bold red on white`.
+  template <typename Char>
+  constexpr fmt::text_style parse_style(std::basic_string_view<Char> def) {
+    fmt::text_style style{};
+    if (const auto error = detail::parse_style_to(def, style))
+      throw runtime_error(std::string_view(error));
+    return style;
+  }
+
+  /// Combines `inner` into `outer`. Colors of `inner` take precedence.
+  constexpr fmt::text_style merge_style(const fmt::text_style& outer,
+                                        const fmt::text_style& inner) {
+    fmt::text_style style{};
+    std::uint8_t bits = 0;
+    if (outer.has_emphasis())
+      bits |= static_cast<std::uint8_t>(outer.get_emphasis());
+    if (inner.has_emphasis())
+      bits |= static_cast<std::uint8_t>(inner.get_emphasis());
+    if (bits != 0)
+      style |= fmt::text_style(static_cast<fmt::emphasis>(bits));
+    if (inner.has_foreground())
+      style |= fmt::fg(inner.get_foreground());
+    else if (outer.has_foreground())
+      style |= fmt::fg(outer.get_foreground());
+    if (inner.has_background())
+      style |= fmt::bg(inner.get_background());
+    else if (outer.has_background())
+      style |= fmt::bg(outer.get_background());
+    return style;
+  }
+
+  // parse_markup
+
+  /// Parses `markup` in a single pass and calls `on_text(text, style)` for
+  /// every piece of text in order. `text` views into `markup`; consecutive
+  /// pieces may share a style, e.g. around an escape.
+  /// @throw rich::runtime_error if `markup` is malformed and `mode` is strict
+  template <typename Char, class F>
+  constexpr void parse_markup(const std::basic_string_view<Char> markup,
+                              F&& on_text,
+                              const markup_mode mode = markup_mode::strict) {
+    struct entry {
+      std::basic_string_view<Char> tag{};
+      fmt::text_style style{};
+      // offset of the opening tag
+      std::size_t offset = 0;
+    };
+    const bool strict = mode == markup_mode::strict;
+    constexpr std::size_t max_depth = 32;
+    std::array<entry, max_depth + 1> stack{};
+    // NOTE: GCC 12 の定数評価では値初期化した text_style が
+    //       未初期化と扱われるため、明示的に代入する
+    stack[0].style = fmt::text_style();
+    std::size_t depth = 0;
+
+    auto is_tag_start = [](const Char c) {
+      return ('a' <= c and c <= 'z') or ('A' <= c and c <= 'Z') or c == '#'
+             or c == '/';
+    };
+
+    const auto n = markup.size();
+    std::size_t first = 0; // 未出力のテキストの先頭
+    // i より後の最初の '[' と ']' の位置。i を越えたときだけ探し直すので、
+    // 閉じていないタグが多くても全体で一度しか走査しない
+    std::size_t next_open = 0, next_close = 0;
+    for (std::size_t i = 0; i < n;) {
+      const Char c = markup[i];
+      if (c == '\\' and i + 1 < n
+          and (markup[i + 1] == '[' or markup[i + 1] == '\\')) {
+        if (first < i)
+          on_text(markup.substr(first, i - first), stack[depth].style);
+        // エスケープされた文字は次のテキストの先頭になる
+        first = i + 1;
+        i += 2;
+        continue;
+      }
+      if (c != '[' or i + 1 == n or not is_tag_start(markup[i + 1])) {
+        ++i;
+        continue;
+      }
+      // lenient なら不正なタグはそのままテキストとして残す
+      const char* error = nullptr;
+      if (next_open != markup.npos and next_open <= i)
+        next_open = markup.find(Char('['), i + 1);
+      if (next_close != markup.npos and next_close <= i)
+        next_close = markup.find(Char(']'), i + 1);
+      const auto close = next_close;
+      // タグは '[' を含まない
+      const bool terminated = close != markup.npos and close < next_open;
+      const auto tag = terminated ? markup.substr(i + 1, close - i - 1)
+                                  : std::basic_string_view<Char>();
+      fmt::text_style style{};
+      if (not terminated)
+        error = "Unterminated markup tag";
+      else if (tag[0] == '/' and depth == 0)
+        error = "Closing markup tag without an open tag";
+      else if (tag[0] == '/' and tag.size() != 1
+               and tag.substr(1) != stack[depth].tag)
+        error = "Mismatched closing markup tag";
+      else if (tag[0] != '/' and depth == max_depth)
+        error = "Markup nested too deeply";
+      else if (tag[0] != '/')
+        error = detail::parse_style_to(tag, style);
+      if (error != nullptr) {
+        if (strict)
+          throw runtime_error("{} at offset {}", error, i);
+        ++i;
+        continue;
+      }
+      if (first < i)
+        on_text(markup.substr(first, i - first), stack[depth].style);
+      if (tag[0] == '/') {
+        --depth;
+      } else {
+        stack[depth + 1] = {tag, merge_style(stack[depth].style, style), i};
+        ++depth;
+      }
+      i = first = close + 1;
+    }
+    if (strict and depth != 0)
+      throw runtime_error("Unclosed markup tag at offset {}",
+                          stack[depth].offset);
+    if (first < n)
+      on_text(markup.substr(first), stack[depth].style);
+  }
+
+  // markup_segments_to
+
+  /// Parses `markup` at run time and writes its segments to `out`. The text
+  /// of every segment views into `markup`; nothing is copied or allocated.
+  /// @throw rich::runtime_error if the markup is malformed and `mode` is
+  ///        strict
+  template <typename Char,
+            std::output_iterator<const segment<Char>&> Out>
+  Out markup_segments_to(Out out, const std::basic_string_view<Char> markup,
+                         const markup_mode mode = markup_mode::strict) {
+    parse_markup(
+      markup,
+      [&out](std::basic_string_view<Char> sv, const fmt::text_style& style) {
+        *out++ = segment<Char>(sv, style);
+      },
+      mode);
+    return out;
+  }
+
+  /// @return segments of `markup`, viewing into `markup`
+  template <typename Char>
+  std::vector<segment<Char>>
+  markup_segments(const std::basic_string_view<Char> markup,
+                  const markup_mode mode = markup_mode::strict) {
+    std::vector<segment<Char>> segs;
+    markup_segments_to<Char>(std::back_inserter(segs), markup, mode);
+    return segs;
+  }
+
+  // compiled_markup
+
+  /// Markup parsed at compile time. Consecutive text of the same style is
+  /// merged into a piece, and the styles are interned. If the markup
+  /// contains replacement fields, each piece is a format string whose
+  /// automatic indices are made explicit, e.g. `{}` becomes `{0}`.
+  template <typename Char, std::size_t NText, std::size_t NPieces,
+            std::size_t NStyles>
+  struct compiled_markup {
+    using char_type = Char;
+
+    struct piece {
+      std::size_t first = 0;
+      std::size_t size = 0;
+      std::uint16_t style = 0;
+      // the text contains `{` or `}`
+      bool fields = false;
+    };
+
+    std::array<Char, NText> text{};
+    std::array<piece, NPieces> pieces{};
+    std::array<fmt::text_style, NStyles> styles{};
+
+    constexpr std::basic_string_view<Char> text_of(const piece& p) const {
+      return {text.data() + p.first, p.size};
+    }
+    constexpr const fmt::text_style& style_of(const piece& p) const {
+      return styles[p.style];
+    }
+
+    /// @return the pieces as segments referring to `*this`
+    std::array<segment<Char>, NPieces> to_segments() const {
+      std::array<segment<Char>, NPieces> segs{};
+      for (std::size_t i = 0; i < NPieces; ++i)
+        segs[i] = segment<Char>(text_of(pieces[i]), style_of(pieces[i]));
+      return segs;
+    }
+  };
+
+  namespace detail {
+    template <typename Char>
+    struct markup_builder {
+      struct piece {
+        std::size_t first = 0;
+        std::size_t size = 0;
+        std::uint16_t style = 0;
+        bool fields = false;
+      };
+      std::vector<Char> text{};
+      std::vector<piece> pieces{};
+      std::vector<fmt::text_style> styles{};
+      std::size_t next_arg = 0;
+
+      constexpr std::uint16_t intern(const fmt::text_style& style) {
+        for (std::size_t i = 0; i < styles.size(); ++i)
+          if (style_equal(styles[i], style))
+            return static_cast<std::uint16_t>(i);
+        styles.push_back(style);
+        return static_cast<std::uint16_t>(styles.size() - 1);
+      }
+
+      constexpr void append_index(std::size_t n) {
+        Char digits[20]{};
+        std::size_t len = 0;
+        do {
+          digits[len++] = static_cast<Char>('0' + n % 10);
+          n /= 10;
+        } while (n != 0);
+        while (len != 0)
+          text.push_back(digits[--len]);
+      }
+
+      // `{}` と `{:...}` に引数の番号を補う
+      constexpr bool append(std::basic_string_view<Char> sv) {
+        bool fields = false;
+        for (std::size_t i = 0; i < sv.size(); ++i) {
+          const Char c = sv[i];
+          text.push_back(c);
+          if (c == '}') {
+            fields = true;
+          } else if (c == '{') {
+            fields = true;
+            if (i + 1 < sv.size() and sv[i + 1] == '{') {
+              text.push_back(sv[++i]);
+            } else if (i + 1 < sv.size()
+                       and (sv[i + 1] == '}' or sv[i + 1] == ':')) {
+              append_index(next_arg++);
+            }
+          }
+        }
+        return fields;
+      }
+
+      constexpr void operator()(std::basic_string_view<Char> sv,
+                                const fmt::text_style& style) {
+        const auto id = intern(style);
+        if (pieces.empty() or pieces.back().style != id)
+          pieces.push_back({text.size(), 0, id, false});
+        auto& p = pieces.back();
+        const auto before = text.size();
+        p.fields = append(sv) or p.fields;
+        p.size += text.size() - before;
+      }
+    };
+
+    template <typename Char>
+    constexpr markup_builder<Char>
+    build_markup(std::basic_string_view<Char> markup) {
+      markup_builder<Char> builder;
+      parse_markup(markup, builder);
+      return builder;
+    }
+  } // namespace detail
+
+  // compile_markup
+
+  namespace detail {
+    template <basic_fixed_string S>
+    consteval auto compile_markup_data() {
+      using Char = typename decltype(S)::char_type;
+      constexpr auto sizes = [] {
+        auto b = build_markup(S.view());
+        return std::array{b.text.size(), b.pieces.size(), b.styles.size()};
+      }();
+      compiled_markup<Char, sizes[0], sizes[1], sizes[2]> m{};
+      auto b = build_markup(S.view());
+      for (std::size_t i = 0; i < sizes[0]; ++i)
+        m.text[i] = b.text[i];
+      for (std::size_t i = 0; i < sizes[1]; ++i)
+        m.pieces[i] = {b.pieces[i].first, b.pieces[i].size, b.pieces[i].style,
+                       b.pieces[i].fields};
+      for (std::size_t i = 0; i < sizes[2]; ++i)
+        m.styles[i] = b.styles[i];
+      return m;
+    }
+
+    // 置換フィールドのある piece を Args の書式文字列として検査する
+    template <typename Char, basic_fixed_string S, class... Args>
+    consteval bool check_markup_fields() {
+      constexpr auto m = compile_markup_data<S>();
+      for (const auto& p : m.pieces)
+        if (p.fields)
+          (void)fmt::basic_format_string<Char, Args...>(m.text_of(p));
+      return true;
+    }
+  } // namespace detail
+
+  /// markup_string
+  /// Markup `S` parsed at compile time. The replacement fields are checked
+  /// against the argument types when `markup_format_to` is instantiated.
+  template <basic_fixed_string S>
+  struct markup_string : decltype(detail::compile_markup_data<S>()) {
+    consteval markup_string()
+      : decltype(detail::compile_markup_data<S>())(
+        detail::compile_markup_data<S>()) {}
+  };
+
+  template <basic_fixed_string S>
+  consteval markup_string<S> compile_markup() {
+    return {};
+  }
+
+  namespace markup_literals {
+    template <basic_fixed_string S>
+    consteval auto operator""_markup() {
+      return compile_markup<S>();
+    }
+  } // namespace markup_literals
+
+  // markup_format_to
+
+  /// Renders `m` with `args`. No markup is parsed at run time, and a
+  /// replacement field which does not match `args` is a compile error.
+  template <typename Char, std::output_iterator<const Char&> Out,
+            basic_fixed_string S, class... Args>
+  requires std::same_as<Char, typename decltype(S)::char_type>
+  Out markup_format_to(Out out, const markup_string<S>& m,
+                       const Args&... args) {
+    static_assert(detail::check_markup_fields<Char, S, Args...>());
+    using context = fmt::buffer_context<Char>;
+    const auto fargs = fmt::make_format_args<context>(args...);
+    fmt::basic_memory_buffer<Char> buf;
+    for (const auto& p : m.pieces) {
+      const auto [out2, has_style] = set_style<Char>(out, m.style_of(p));
+      out = out2;
+      if (p.fields) {
+        buf.clear();
+        fmt::vformat_to(std::back_inserter(buf),
+                        fmt::basic_string_view<Char>(m.text_of(p)),
+                        fmt::basic_format_args<context>(fargs));
+        instrument::add_text(buf.size());
+        out = copy_to<Char>(out, std::basic_string_view<Char>(buf.data(),
+                                                              buf.size()));
+      } else {
+        instrument::add_text(m.text_of(p).size());
+        out = copy_to<Char>(out, m.text_of(p));
+      }
+      if (has_style)
+        out = reset_style<Char>(out);
+    }
+    return out;
+  }
+
+  /// @return `m` rendered with `args`
+  template <basic_fixed_string S, class... Args>
+  std::basic_string<typename decltype(S)::char_type>
+  markup_format(const markup_string<S>& m, const Args&... args) {
+    using Char = typename decltype(S)::char_type;
+    std::basic_string<Char> str;
+    markup_format_to<Char>(std::back_inserter(str), m, args...);
+    return str;
+  }
+} // namespace rich
@@ -1,6 +1,10 @@
 /// @file panel.hpp
 #pragma once
+#include <iterator> // std::back_inserter
+#include <string>
+
 #include <rich/format.hpp>
+#include <rich/style/border.hpp>
 #include <rich/style/box.hpp>
 #include <rich/style/format_spec.hpp>
 #include <rich/style/line_formatter.hpp>
@@ -36,14 +40,74 @@ namespace rich {
   template <line_range R>
   panel(R&&, int = {})
     -> panel<lines<typename std::ranges::range_value_t<R>::char_type>>;
+
+  namespace detail {
+    template <class T>
+    inline constexpr bool is_panel_v = false;
+
+    template <class L>
+    inline constexpr bool is_panel_v<panel<L>> = true;
+  } // namespace detail
 } // namespace rich
 
 template <rich::line_formattable L, std::same_as<typename L::char_type> Char>
 struct rich::line_formatter<rich::panel<L>, Char> {
 private:
+  using string_type = std::basic_string<Char>;
+  // contents も panel なら、その行に自身の枠を付けさせる
+  static constexpr bool fused = rich::detail::is_panel_v<L>;
+
   const rich::panel<L>* ptr_ = nullptr;
   line_formatter<L, Char> line_fmtr_;
   std::uint32_t phase_ = 0;
+  // 外側の panel から渡された左右の枠と余白
+  string_type outer_left_{}, outer_right_{};
+  // outer_left_ + 自身の左の枠, 自身の右の枠 + outer_right_
+  // NOTE: outer_left_/outer_right_ と幅から作るので、どちらかが変わると
+  //       rebuild() で作り直す。内側の panel の外枠もそこで設定し直す
+  string_type mid_left_{}, mid_right_{};
+  instrument::bytes outer_counts_{}, mid_counts_{};
+  std::size_t width_ = 0;
+  bool stale_ = true;
+
+  // 幅 n の行の前後に付ける文字列を求める
+  // format_to の最初と、set_outer_border の後か n が変わったときに呼ばれる
+  void rebuild(const std::size_t n, const std::size_t contents_width) {
+    const auto& box = ptr_->box;
+    const auto& bs = ptr_->border_spec;
+    mid_left_ = outer_left_;
+    mid_right_.clear();
+    mid_counts_ = outer_counts_;
+    mid_counts_ += instrument::measure([&] {
+      spec_format_to<Char>(std::back_inserter(mid_left_), bs, mid_left(box));
+      rspec_format_to<Char>(std::back_inserter(mid_right_), bs,
+                            mid_right(box));
+    });
+    mid_right_ += outer_right_;
+    if constexpr (fused) {
+      // NOTE: The width of a panel does not depend on its line, so the
+      //       padding around the inner panel is the same on every line.
+      const auto& cs = ptr_->contents_spec;
+      auto left = mid_left_;
+      auto right = string_type();
+      auto counts = mid_counts_;
+      if (contents_width != line_formatter_npos) {
+        const auto fillwidth = sat_sub(
+          contents_width, line_formatted_size(line_fmtr_, contents_width));
+        const auto [l, r] = padding_size(cs.align, fillwidth);
+        counts += instrument::measure([&] {
+          // clang-format off
+          padded_format_to<Char>(std::back_inserter(left), cs.style, "", cs.fill, 0, l);
+          padded_format_to<Char>(std::back_inserter(right), cs.style, "", cs.fill, 0, r);
+          // clang-format on
+        });
+      }
+      right += mid_right_;
+      line_fmtr_.set_outer_border(left, right, counts);
+    }
+    width_ = n;
+    stale_ = false;
+  }
 
 public:
   explicit line_formatter(const rich::panel<L>& l)
@@ -59,6 +123,22 @@ public:
     return ptr_->contents_spec.width;
   }
 
+  /// Sets the outer border: every following line starts with `left` and
+  /// ends with `right`. Called by an enclosing panel or static_table, which
+  /// then emits the lines of `*this` as they are, so their borders are
+  /// written once per line instead of once per nesting level. `counts` are
+  /// the bytes of `left` and `right`.
+  /// The borders of `*this` are rebuilt around the new outer border before
+  /// the next line is formatted.
+  void set_outer_border(std::basic_string_view<Char> left,
+                        std::basic_string_view<Char> right,
+                        const instrument::bytes& counts = {}) {
+    outer_left_ = left;
+    outer_right_ = right;
+    outer_counts_ = counts;
+    stale_ = true;
+  }
+
   template <std::output_iterator<const Char&> Out>
   Out format_to(Out out, const std::size_t n = line_formatter_npos) {
     assert(ptr_ != nullptr);
@@ -68,44 +148,45 @@ public:
     // calculate contents_width
     const auto width = std::min(ptr_->contents_spec.width, n);
     const auto contents_width = npos_sub(width, ptr_->border_spec.width * 2);
+    if (stale_ or width_ != n)
+      rebuild(n, contents_width);
 
     switch (phase_) {
     case 0: {
       // ╭─╮ top
       ++phase_;
-      auto bs = ptr_->border_spec;
-      if (bs.align == align_t::left)
-        bs.fill = top_mid(box);
+      instrument::replay(outer_counts_);
+      out = copy_to<Char>(out, outer_left_);
       // clang-format off
-      out = spec_format_to<Char>(out, bs, top_left(box));
-      out = line_format_to<Char>(out, bs.style, ptr_->title, top_mid(box), align_t::center, contents_width);
-      out = rspec_format_to<Char>(out, bs, top_right(box));
+      out = cached_border_format_to<Char>(out, ptr_->border_spec, top_left(box), top_mid(box), top_right(box), ptr_->title, contents_width);
       // clang-format on
-      return out;
+      return copy_to<Char>(out, outer_right_);
     }
     case 1: {
       if (line_fmtr_) {
         // │ │ mid
-        const auto& cs = ptr_->contents_spec;
-        const auto& bs = ptr_->border_spec;
-        // clang-format off
-        out = spec_format_to<Char>(out, bs, mid_left(box));
-        out = line_format_to<Char>(out, cs.style, line_fmtr_, cs.fill, cs.align, contents_width);
-        out = rspec_format_to<Char>(out, bs, mid_right(box));
-        // clang-format on
+        if constexpr (fused) {
+          out = counted_format_to(out, line_fmtr_, contents_width);
+        } else {
+          const auto& cs = ptr_->contents_spec;
+          instrument::replay(mid_counts_);
+          // clang-format off
+          out = copy_to<Char>(out, mid_left_);
+          out = line_format_to<Char>(out, cs.style, line_fmtr_, cs.fill, cs.align, contents_width);
+          out = copy_to<Char>(out, mid_right_);
+          // clang-format on
+        }
         if (ptr_->nomatter and not line_fmtr_)
           ++phase_;
       } else {
         // ╰─╯ bottom
         ++phase_;
-        auto bs = ptr_->border_spec;
-        if (bs.align == align_t::left)
-          bs.fill = bottom_mid(box);
+        instrument::replay(outer_counts_);
+        out = copy_to<Char>(out, outer_left_);
         // clang-format off
-        out = spec_format_to<Char>(out, bs, bottom_left(box));
-        out = line_format_to<Char>(out, bs.style, "", bottom_mid(box), {}, contents_width);
-        out = rspec_format_to<Char>(out, bs, bottom_right(box));
+        out = cached_border_format_to<Char>(out, ptr_->border_spec, bottom_left(box), bottom_mid(box), bottom_right(box), {}, contents_width);
         // clang-format on
+        out = copy_to<Char>(out, outer_right_);
       }
       return out;
     }
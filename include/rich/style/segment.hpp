@@ -55,6 +55,7 @@ public:
     auto out = ctx.out();
     const auto [out2, has_style] = rich::set_style<Char>(out, seg.style());
     ctx.advance_to(out2);
+    rich::instrument::add_text(seg.text().size());
     out = fmtr.format(seg.text(), ctx);
     if (has_style)
       out = rich::reset_style<Char>(out);
@@ -0,0 +1,53 @@
+/// @file snapshot.hpp
+#pragma once
+#include <iterator> // std::back_inserter
+#include <string_view>
+
+#include <rich/instrument.hpp>
+#include <rich/style/lines.hpp>
+#include <rich/style/table.hpp>
+#include <rich/style/text_arena.hpp>
+
+namespace rich::instrument {
+  /// @return `snap` as a table with a row for each renderable type. Types
+  ///         without any count are omitted.
+  inline adopted<table<char>> to_table(const snapshot& snap) {
+    constexpr std::string_view header[] = {
+      "type", "lines", "text", "padding", "escape", "set_style", "allocs", "us",
+    };
+    constexpr std::size_t number_width = 10;
+
+    std::size_t name_width = header[0].size();
+    for (const auto& c : snap.entries)
+      if (c.name.size() > name_width)
+        name_width = c.name.size();
+
+    text_arena arena;
+    const auto head = arena.format(
+      "{:<{}}{:>{}}{:>{}}{:>{}}{:>{}}{:>{}}{:>{}}{:>{}}", header[0],
+      name_width, header[1], number_width, header[2], number_width, header[3],
+      number_width, header[4], number_width, header[5], number_width,
+      header[6], number_width, header[7], number_width);
+    fmt::memory_buffer buf;
+    for (const auto& c : snap.entries) {
+      if (c.lines == 0 and c.text_bytes == 0 and c.padding_bytes == 0
+          and c.escape_bytes == 0 and c.allocations == 0)
+        continue;
+      if (buf.size() != 0)
+        buf.push_back('\n');
+      fmt::format_to(std::back_inserter(buf),
+                     "{:<{}}{:>{}}{:>{}}{:>{}}{:>{}}{:>{}}{:>{}}{:>{}}", c.name,
+                     name_width, c.lines, number_width, c.text_bytes,
+                     number_width, c.padding_bytes, number_width,
+                     c.escape_bytes, number_width, c.set_style_calls,
+                     number_width, c.allocations, number_width,
+                     c.nanoseconds / 1000, number_width);
+    }
+    const auto body = arena.append(std::string_view(buf.data(), buf.size()));
+
+    table<char> t(lines<char>{{head, {}}}, lines<char>{{body, {}}});
+    t.title = "instrument";
+    t.contents_spec.width = head.size() + t.border_spec.width * 2;
+    return adopt(std::move(arena), std::move(t));
+  }
+} // namespace rich::instrument
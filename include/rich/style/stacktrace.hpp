@@ -0,0 +1,60 @@
+/// @file stacktrace.hpp
+#pragma once
+#include <iterator> // std::back_inserter
+#include <string>
+#include <string_view>
+#include <fmt/format.h>
+
+#include <rich/stacktrace.hpp>
+#include <rich/style/line_formatter.hpp>
+
+template <>
+struct rich::line_formatter<rich::stacktrace, char> {
+private:
+  const stacktrace* ptr_ = nullptr;
+  std::size_t current_ = 0;
+  // the current frame, symbolized and formatted lazily
+  std::string line_{};
+
+  void prepare() {
+    line_.clear();
+    if (current_ == std::ranges::size(*ptr_))
+      return;
+    const auto fi = ptr_->frame(current_);
+    auto out = std::back_inserter(line_);
+    if (not fi.function.empty())
+      fmt::format_to(out, "#{} {} in {}+{:#x}", current_, fi.address,
+                     fi.function, fi.offset);
+    else if (not fi.object.empty())
+      fmt::format_to(out, "#{} {} in {}+{:#x}", current_, fi.address,
+                     fi.object, fi.offset);
+    else
+      fmt::format_to(out, "#{} {}", current_, fi.address);
+  }
+
+public:
+  explicit line_formatter(const stacktrace& st) : ptr_(std::addressof(st)) {
+    prepare();
+  }
+
+  explicit operator bool() const {
+    return ptr_ != nullptr and current_ != std::ranges::size(*ptr_);
+  }
+
+  std::size_t formatted_size() const { return line_.size(); }
+
+  template <std::output_iterator<const char&> Out>
+  Out format_to(Out out, const std::size_t n = line_formatter_npos) {
+    assert(ptr_ != nullptr);
+    const auto sv = std::string_view(line_).substr(0, n);
+    instrument::add_text(sv.size());
+    out = copy_to<char>(out, sv);
+    ++current_;
+    prepare();
+    return out;
+  }
+};
+
+template <>
+struct fmt::formatter<rich::stacktrace, char>
+  : rich::line_formattable_default_formatter<rich::stacktrace, char> {};
@@ -0,0 +1,214 @@
+/// @file static_table.hpp
+#pragma once
+#include <iterator> // std::back_inserter
+#include <string>
+#include <tuple>
+#include <utility> // std::index_sequence
+
+#include <rich/format.hpp>
+#include <rich/math.hpp>
+#include <rich/style/border.hpp>
+#include <rich/style/box.hpp>
+#include <rich/style/format_spec.hpp>
+#include <rich/style/line_formatter.hpp>
+#include <rich/style/panel.hpp>
+
+namespace rich {
+  /// static_table
+  /// A table whose cells are held in a tuple instead of being type-erased by
+  /// `cell`. Renders like `table`.
+  template <line_formattable T, line_formattable... U>
+  requires (std::same_as<typename T::char_type, typename U::char_type> and ...)
+  struct static_table {
+    using char_type = typename T::char_type;
+    std::tuple<T, U...> contents{};
+    box_t<char_type> box = box::Rounded<char_type>;
+    format_spec<char_type> contents_spec{
+      .style = fg(fmt::terminal_color::red),
+      .fill = mid_mid(box),
+      .align = align_t::left,
+      .width = 80,
+    };
+    format_spec<char_type> border_spec{
+      .style = fg(fmt::terminal_color::red),
+      .fill = mid_mid(box),
+      .align = align_t::left,
+      .width = 2,
+    };
+    std::basic_string_view<char_type> title{};
+    bool nomatter = false;
+
+    static_table() = default;
+    constexpr explicit static_table(T t, U... u)
+      : contents(std::move(t), std::move(u)...) {}
+
+    static constexpr std::size_t size() { return 1 + sizeof...(U); }
+  };
+
+  template <line_formattable T, line_formattable... U>
+  static_table(T, U...) -> static_table<T, U...>;
+} // namespace rich
+
+template <typename Char, class... Ts>
+requires std::same_as<Char, typename rich::static_table<Ts...>::char_type>
+struct rich::line_formatter<rich::static_table<Ts...>, Char> {
+private:
+  using string_type = std::basic_string<Char>;
+  using tuple_type = std::tuple<line_formatter<Ts, Char>...>;
+  static constexpr std::size_t size_ = sizeof...(Ts);
+
+  const rich::static_table<Ts...>* ptr_ = nullptr;
+  tuple_type lfmtrs_;
+  std::uint32_t phase_ = 0;
+  std::size_t current_ = 0;
+  // 左右の枠
+  string_type mid_left_{}, mid_right_{};
+  instrument::bytes mid_counts_{};
+  std::size_t width_ = 0;
+  bool stale_ = true;
+
+  // f(std::integral_constant<std::size_t, I>, line_formatter&) for I == i
+  template <class F>
+  void visit(const std::size_t i, F&& f) {
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+      (void)((i == I
+              and (f(std::integral_constant<std::size_t, I>{},
+                     std::get<I>(lfmtrs_)),
+                   true))
+             or ...);
+    }(std::index_sequence_for<Ts...>{});
+  }
+
+  bool has_line() const {
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return ((current_ == I and bool(std::get<I>(lfmtrs_))) or ...);
+    }(std::index_sequence_for<Ts...>{});
+  }
+
+  // 幅 n の行の前後に付ける文字列を求める
+  // format_to の最初と n が変わったときに呼ばれる
+  void rebuild(const std::size_t n, const std::size_t contents_width) {
+    const auto& box = ptr_->box;
+    const auto& cs = ptr_->contents_spec;
+    const auto& bs = ptr_->border_spec;
+    mid_left_.clear();
+    mid_right_.clear();
+    mid_counts_ = instrument::measure([&] {
+      spec_format_to<Char>(std::back_inserter(mid_left_), bs, mid_left(box));
+      rspec_format_to<Char>(std::back_inserter(mid_right_), bs,
+                            mid_right(box));
+    });
+    // panel の cell には枠と余白を付けて描かせる
+    for (std::size_t i = 0; i < size_; ++i) {
+      visit(i, [&](auto I, auto& lf) {
+        using L = std::tuple_element_t<I, std::tuple<Ts...>>;
+        if constexpr (rich::detail::is_panel_v<L>) {
+          auto left = mid_left_;
+          auto right = string_type();
+          auto counts = mid_counts_;
+          if (contents_width != line_formatter_npos) {
+            const auto fillwidth =
+              sat_sub(contents_width, line_formatted_size(lf, contents_width));
+            const auto [l, r] = padding_size(cs.align, fillwidth);
+            counts += instrument::measure([&] {
+              // clang-format off
+              padded_format_to<Char>(std::back_inserter(left), cs.style, "", cs.fill, 0, l);
+              padded_format_to<Char>(std::back_inserter(right), cs.style, "", cs.fill, 0, r);
+              // clang-format on
+            });
+          }
+          right += mid_right_;
+          lf.set_outer_border(left, right, counts);
+        }
+      });
+    }
+    width_ = n;
+    stale_ = false;
+  }
+
+public:
+  explicit line_formatter(const rich::static_table<Ts...>& t)
+    : ptr_(std::addressof(t)),
+      lfmtrs_(std::make_from_tuple<tuple_type>(t.contents)),
+      phase_(t.nomatter ? std::apply(
+                            [](const auto&... lf) -> std::uint32_t {
+                              return (bool(lf) or ...) ? 1 : 2;
+                            },
+                            lfmtrs_)
+                        : 0) {}
+
+  constexpr explicit operator bool() const {
+    return ptr_ != nullptr and phase_ != 2;
+  }
+
+  constexpr std::size_t formatted_size() const {
+    assert(ptr_ != nullptr);
+    return ptr_->contents_spec.width;
+  }
+
+  template <std::output_iterator<const Char&> Out>
+  Out format_to(Out out, const std::size_t n = line_formatter_npos) {
+    assert(ptr_ != nullptr);
+    const auto& box = ptr_->box;
+    assert(std::ranges::size(box) == std::ranges::size(box::Rounded<Char>));
+
+    // calculate contents_width
+    const auto width = std::min(ptr_->contents_spec.width, n);
+    const auto contents_width = npos_sub(width, ptr_->border_spec.width * 2);
+    if (stale_ or width_ != n)
+      rebuild(n, contents_width);
+
+    switch (phase_) {
+    case 0: {
+      // ╭─┬╮ top
+      ++phase_;
+      // clang-format off
+      return cached_border_format_to<Char>(out, ptr_->border_spec, top_left(box), top_mid(box), top_right(box), ptr_->title, contents_width);
+      // clang-format on
+    }
+    case 1: {
+      if (has_line()) {
+        // │ ││ mid
+        visit(current_, [&](auto I, auto& lf) {
+          using L = std::tuple_element_t<I, std::tuple<Ts...>>;
+          if constexpr (rich::detail::is_panel_v<L>) {
+            out = counted_format_to(out, lf, contents_width);
+          } else {
+            const auto& cs = ptr_->contents_spec;
+            instrument::replay(mid_counts_);
+            // clang-format off
+            out = copy_to<Char>(out, mid_left_);
+            out = line_format_to<Char>(out, cs.style, lf, cs.fill, cs.align, contents_width);
+            out = copy_to<Char>(out, mid_right_);
+            // clang-format on
+          }
+        });
+        if (ptr_->nomatter and not has_line() and current_ + 1 == size_)
+          ++phase_;
+      } else {
+        ++current_;
+        if (current_ != size_) {
+          // ├─┼┤ row
+          // clang-format off
+          out = cached_border_format_to<Char>(out, ptr_->border_spec, row_left(box), row_mid(box), row_right(box), {}, contents_width);
+          // clang-format on
+        } else {
+          // ╰─┴╯ bottom
+          ++phase_;
+          // clang-format off
+          out = cached_border_format_to<Char>(out, ptr_->border_spec, bottom_left(box), bottom_mid(box), bottom_right(box), {}, contents_width);
+          // clang-format on
+        }
+      }
+      return out;
+    }
+    default:
+      RICH_UNREACHABLE();
+    }
+  }
+};
+
+template <typename Char, class... Ts>
+struct fmt::formatter<rich::static_table<Ts...>, Char>
+  : rich::line_formattable_default_formatter<rich::static_table<Ts...>, Char> {
+};
@@ -42,8 +42,9 @@ namespace rich {
     }
   };
 
-  auto syntax_highlight(std::string_view sv,
-                        theme_t theme = theme_t(theme::Default)) {
+  inline auto syntax_highlight(std::string_view sv,
+                               theme_t theme = theme_t(theme::Default)) {
+    [[maybe_unused]] const trace::scope ts("syntax_highlight", "highlight");
     static const std::regex re(
       R"((//.*?\n)|\b(auto|const|int|void|if|else|throw|try|catch|return)\b|(\b\d+\b)|(".*?"))");
     assert(theme.size() >= icast<std::size_t>(re.mark_count()));
@@ -1,9 +1,13 @@
 /// @file table.hpp
 #pragma once
+#include <memory>          // std::allocator_arg_t
+#include <memory_resource> // std::pmr::polymorphic_allocator
 #include <vector>
 
 #include <rich/format.hpp>
 #include <rich/math.hpp>
+#include <rich/parallel.hpp>
+#include <rich/style/border.hpp>
 #include <rich/style/box.hpp>
 #include <rich/style/cell.hpp>
 #include <rich/style/format_spec.hpp>
@@ -15,9 +19,10 @@ namespace rich {
   struct table {
     using value_type = cell<Char>;
     using char_type = Char;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
 
   private:
-    std::vector<value_type> cells_{};
+    std::pmr::vector<value_type> cells_{};
 
   public:
     box_t<char_type> box = box::Rounded<char_type>;
@@ -51,12 +56,39 @@ namespace rich {
     requires (std::same_as<typename std::remove_cvref_t<T>::char_type, typename std::remove_cvref_t<U>::char_type> and ... and (sizeof...(U) > 0))
       // clang-format on
       table(T&& t, U&&... u)
-      : cells_(make_reserved<std::vector<value_type>>(1 + sizeof...(U))) {
+      : cells_(make_reserved<std::pmr::vector<value_type>>(1 + sizeof...(U))) {
       push_back(std::forward<T>(t));
       using swallow = std::initializer_list<int>;
       (void)swallow{(void(push_back(std::forward<U>(u))), 0)...};
     }
 
+    // allocator-extended ctor
+    // NOTE: The cells, their contents and the line_formatters created while
+    //       rendering are allocated through `alloc`.
+    table(std::allocator_arg_t, const allocator_type& alloc) : cells_(alloc) {}
+
+    template <line_formattable... T>
+    // clang-format off
+    requires ((sizeof...(T) > 0) and ... and (not std::same_as<std::remove_cvref_t<T>, table>))
+      // clang-format on
+      table(std::allocator_arg_t, const allocator_type& alloc, T&&... t)
+      : cells_(make_reserved<std::pmr::vector<value_type>>(sizeof...(T),
+                                                           alloc)) {
+      using swallow = std::initializer_list<int>;
+      (void)swallow{(void(push_back(std::forward<T>(t))), 0)...};
+    }
+
+    table(std::allocator_arg_t, const allocator_type& alloc, const table& t)
+      : cells_(t.cells_, alloc), box(t.box), contents_spec(t.contents_spec),
+        border_spec(t.border_spec), title(t.title), nomatter(t.nomatter) {}
+
+    table(std::allocator_arg_t, const allocator_type& alloc, table&& t)
+      : cells_(std::move(t.cells_), alloc), box(t.box),
+        contents_spec(t.contents_spec), border_spec(t.border_spec),
+        title(t.title), nomatter(t.nomatter) {}
+
+    allocator_type get_allocator() const { return cells_.get_allocator(); }
+
     auto begin() const { return cells_.begin(); }
     auto end() const { return cells_.end(); }
     auto empty() const { return cells_.empty(); }
@@ -68,6 +100,13 @@ namespace rich {
 
     void push_back(value_type&& ce) { cells_.push_back(std::move(ce)); }
 
+    template <line_formattable T>
+    requires (not std::same_as<std::remove_cvref_t<T>, value_type>)
+    void push_back(T&& t) {
+      cells_.emplace_back(std::allocator_arg, get_allocator(),
+                          std::forward<T>(t));
+    }
+
     template <class... Args>
     auto& emplace_back(Args&&... args) {
       return cells_.emplace_back(std::forward<Args>(args)...);
@@ -83,14 +122,15 @@ struct rich::line_formatter<rich::table<Char>, Char2> {
 private:
   using line_formatter_type = rich::line_formatter<cell<Char>, Char>;
   const rich::table<Char>* ptr_ = nullptr;
-  std::vector<line_formatter_type> lfmtrs_{};
+  std::pmr::vector<line_formatter_type> lfmtrs_{};
   std::uint32_t phase_ = 0;
-  std::ranges::iterator_t<std::vector<line_formatter_type>> current_ =
+  std::ranges::iterator_t<std::pmr::vector<line_formatter_type>> current_ =
     std::ranges::begin(lfmtrs_);
 
 public:
   explicit line_formatter(const rich::table<Char>& l)
-    : ptr_(std::addressof(l)), lfmtrs_(std::ranges::size(l)),
+    : ptr_(std::addressof(l)),
+      lfmtrs_(std::ranges::size(l), l.get_allocator()),
       phase_([&l]() -> std::uint32_t {
         if (l.nomatter) {
           // NOTE: algorithmはincludeしない方針
@@ -132,15 +172,9 @@ public:
     case 0: {
       // ╭─┬╮ top
       ++phase_;
-      auto bs = ptr_->border_spec;
-      if (bs.align == align_t::left)
-        bs.fill = top_mid(box);
       // clang-format off
-      out = spec_format_to<Char>(out, bs, top_left(box));
-      out = line_format_to<Char>(out, bs.style, ptr_->title, top_mid(box), align_t::center, contents_width);
-      out = rspec_format_to<Char>(out, bs, top_right(box));
+      return cached_border_format_to<Char>(out, ptr_->border_spec, top_left(box), top_mid(box), top_right(box), ptr_->title, contents_width);
       // clang-format on
-      return out;
     }
     case 1: {
       if (*current_) {
@@ -159,24 +193,14 @@ public:
         ++current_;
         if (current_ != std::ranges::end(lfmtrs_)) {
           // ├─┼┤ row
-          auto bs = ptr_->border_spec;
-          if (bs.align == align_t::left)
-            bs.fill = row_mid(box);
           // clang-format off
-          out = spec_format_to<Char>(out, bs, row_left(box));
-          out = line_format_to<Char>(out, bs.style, "", row_mid(box), {}, contents_width);
-          out = rspec_format_to<Char>(out, bs, row_right(box));
+          out = cached_border_format_to<Char>(out, ptr_->border_spec, row_left(box), row_mid(box), row_right(box), {}, contents_width);
           // clang-format on
         } else {
           // ╰─┴╯ bottom
           ++phase_;
-          auto bs = ptr_->border_spec;
-          if (bs.align == align_t::left)
-            bs.fill = bottom_mid(box);
           // clang-format off
-          out = spec_format_to<Char>(out, bs, bottom_left(box));
-          out = line_format_to<Char>(out, bs.style, "", bottom_mid(box), {}, contents_width);
-          out = rspec_format_to<Char>(out, bs, bottom_right(box));
+          out = cached_border_format_to<Char>(out, ptr_->border_spec, bottom_left(box), bottom_mid(box), bottom_right(box), {}, contents_width);
           // clang-format on
         }
       }
@@ -191,3 +215,90 @@ public:
 template <typename Char, typename Char2>
 struct fmt::formatter<rich::table<Char>, Char2>
   : rich::line_formattable_default_formatter<rich::table<Char>, Char2> {};
+
+namespace rich {
+  // parallel_format_to
+
+  /// Renders `t` exactly like `line_formattable_format_to(out, t)`, except
+  /// that the cells are rendered concurrently on `pool` into per-thread
+  /// buffers, which are then concatenated in order with the border rows.
+  /// NOTE: The cells are rendered from several threads at once, so the
+  ///       memory resource of the table must be thread safe.
+  template <typename Char, std::output_iterator<const Char&> Out>
+  Out parallel_format_to(Out out, const table<Char>& t, thread_pool& pool) {
+    if (pool.size() == 1 or std::ranges::size(t) < 2)
+      return line_formattable_format_to(out, t);
+
+    const auto& box = t.box;
+    const auto& cs = t.contents_spec;
+    const auto& bs = t.border_spec;
+    const auto contents_width = npos_sub(cs.width, bs.width * 2);
+
+    // 各 cell の行は描画したスレッドのバッファに置く
+    struct chunk_t {
+      std::size_t worker = 0;
+      std::size_t first = 0;
+      std::size_t size = 0;
+      std::size_t lines = 0;
+    };
+    std::vector<fmt::basic_memory_buffer<Char>> bufs(pool.size());
+    std::vector<chunk_t> chunks(std::ranges::size(t));
+    pool.parallel_for(chunks.size(), [&](const std::size_t i,
+                                         const std::size_t worker) {
+      auto& buf = bufs[worker];
+      auto& chunk = chunks[i];
+      chunk.worker = worker;
+      chunk.first = buf.size();
+      fmt::detail::buffer_appender<Char> bout(buf);
+      line_formatter<cell<Char>, Char> lf(
+        std::ranges::begin(t)[icast<std::ptrdiff_t>(i)]);
+      for (; bool(lf); ++chunk.lines) {
+        if (chunk.lines != 0)
+          *bout++ = '\n';
+        // clang-format off
+        bout = spec_format_to<Char>(bout, bs, mid_left(box));
+        bout = line_format_to<Char>(bout, cs.style, lf, cs.fill, cs.align, contents_width);
+        bout = rspec_format_to<Char>(bout, bs, mid_right(box));
+        // clang-format on
+      }
+      chunk.size = buf.size() - chunk.first;
+    });
+
+    // line_formatter<table> と同じ順序で境界の行を挟む
+    Char dlm = '\0';
+    if (not t.nomatter) {
+      *out++ = std::exchange(dlm, '\n');
+      // clang-format off
+      out = cached_border_format_to<Char>(out, bs, top_left(box), top_mid(box), top_right(box), t.title, contents_width);
+      // clang-format on
+    } else {
+      bool any = false;
+      for (const auto& chunk : chunks)
+        any = any or chunk.lines != 0;
+      if (not any)
+        return out;
+    }
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+      const auto& chunk = chunks[i];
+      if (chunk.lines != 0) {
+        *out++ = std::exchange(dlm, '\n');
+        out = copy_to<Char>(out, std::basic_string_view<Char>(
+                                   bufs[chunk.worker].data() + chunk.first,
+                                   chunk.size));
+        if (t.nomatter and i + 1 == chunks.size())
+          return out;
+      }
+      *out++ = std::exchange(dlm, '\n');
+      if (i + 1 != chunks.size()) {
+        // clang-format off
+        out = cached_border_format_to<Char>(out, bs, row_left(box), row_mid(box), row_right(box), {}, contents_width);
+        // clang-format on
+      } else {
+        // clang-format off
+        out = cached_border_format_to<Char>(out, bs, bottom_left(box), bottom_mid(box), bottom_right(box), {}, contents_width);
+        // clang-format on
+      }
+    }
+    return out;
+  }
+} // namespace rich
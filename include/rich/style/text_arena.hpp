@@ -0,0 +1,189 @@
+/// @file text_arena.hpp
+#pragma once
+#include <cstring>         // std::memcpy
+#include <memory>          // std::allocator_arg_t, std::shared_ptr
+#include <memory_resource> // std::pmr::polymorphic_allocator
+#include <string_view>
+#include <type_traits>     // std::type_identity_t
+#include <utility>         // std::exchange, std::swap
+#include <vector>
+#include <fmt/xchar.h> // fmt::vformat_to_n for any Char
+
+#include <rich/format.hpp>
+#include <rich/style/line_formatter.hpp>
+
+namespace rich {
+  /// basic_text_arena
+  /// Owning storage for the texts of non-owning renderables. Texts are
+  /// appended to chunks that are never moved or freed until the arena is
+  /// destroyed, so the returned views stay valid even if the arena itself is
+  /// moved.
+  template <typename Char = char>
+  struct basic_text_arena {
+    using char_type = Char;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+    static constexpr std::size_t default_chunk_size = 4096;
+
+  private:
+    struct chunk_t {
+      Char* data;
+      std::size_t capacity;
+    };
+
+    std::pmr::vector<chunk_t> chunks_{};
+    Char* cur_ = nullptr;
+    Char* end_ = nullptr;
+    std::size_t chunk_size_ = default_chunk_size;
+    std::size_t size_ = 0;
+
+    // 少なくとも n 文字入るチャンクを新しく確保する
+    void new_chunk(const std::size_t n) {
+      const auto cap = n > chunk_size_ ? n : chunk_size_;
+      auto alloc = get_allocator();
+      chunks_.reserve(chunks_.size() + 1);
+      const auto p = alloc.template allocate_object<Char>(cap);
+      chunks_.push_back({p, cap});
+      cur_ = p;
+      end_ = p + cap;
+    }
+
+    Char* allocate(const std::size_t n) {
+      if (static_cast<std::size_t>(end_ - cur_) < n)
+        new_chunk(n);
+      size_ += n;
+      return std::exchange(cur_, cur_ + n);
+    }
+
+  public:
+    // ctor
+    basic_text_arena() = default;
+
+    explicit basic_text_arena(const std::size_t chunk_size)
+      : basic_text_arena(std::allocator_arg, {}, chunk_size) {}
+
+    // allocator-extended ctor
+    basic_text_arena(std::allocator_arg_t, const allocator_type& alloc,
+                     const std::size_t chunk_size = default_chunk_size)
+      : chunks_(alloc), chunk_size_(chunk_size == 0 ? 1 : chunk_size) {}
+
+    basic_text_arena(const basic_text_arena&) = delete;
+    basic_text_arena& operator=(const basic_text_arena&) = delete;
+
+    basic_text_arena(basic_text_arena&& other) noexcept
+      : chunks_(std::move(other.chunks_)),
+        cur_(std::exchange(other.cur_, nullptr)),
+        end_(std::exchange(other.end_, nullptr)),
+        chunk_size_(other.chunk_size_),
+        size_(std::exchange(other.size_, 0)) {
+      other.chunks_.clear();
+    }
+
+    // NOTE: The allocators must be equal.
+    basic_text_arena& operator=(basic_text_arena&& other) noexcept {
+      assert(get_allocator() == other.get_allocator());
+      basic_text_arena tmp(std::move(other));
+      swap(tmp);
+      return *this;
+    }
+
+    ~basic_text_arena() { release(); }
+
+    void swap(basic_text_arena& other) noexcept {
+      chunks_.swap(other.chunks_);
+      std::swap(cur_, other.cur_);
+      std::swap(end_, other.end_);
+      std::swap(chunk_size_, other.chunk_size_);
+      std::swap(size_, other.size_);
+    }
+
+    allocator_type get_allocator() const { return chunks_.get_allocator(); }
+
+    // observer
+    /// @return number of characters stored
+    std::size_t size() const { return size_; }
+    auto empty() const { return size_ == 0; }
+    /// @return number of chunks allocated
+    std::size_t chunk_count() const { return chunks_.size(); }
+
+    // modifier
+    /// Frees every chunk. All views returned so far are invalidated.
+    void release() noexcept {
+      auto alloc = get_allocator();
+      for (const auto& c : chunks_)
+        alloc.template deallocate_object<Char>(c.data, c.capacity);
+      chunks_.clear();
+      cur_ = end_ = nullptr;
+      size_ = 0;
+    }
+
+    /// @return a view of the copy of `s` stored in `*this`
+    std::basic_string_view<Char> append(const std::basic_string_view<Char> s) {
+      if (s.empty())
+        return {};
+      const auto p = allocate(s.size());
+      std::memcpy(p, s.data(), s.size() * sizeof(Char));
+      return {p, s.size()};
+    }
+
+    /// @return a view of the formatted text stored in `*this`
+    std::basic_string_view<Char>
+    vformat(const fmt::basic_string_view<Char> f,
+            const fmt::basic_format_args<fmt::buffer_context<Char>> args) {
+      // 現在のチャンクの残りに書いてみて、入らなければ必要な大きさの
+      // 新しいチャンクに書き直す
+      const auto avail = static_cast<std::size_t>(end_ - cur_);
+      auto n = fmt::vformat_to_n(cur_, avail, f, args).size;
+      if (n > avail) {
+        new_chunk(n);
+        n = fmt::vformat_to_n(cur_, n, f, args).size;
+      }
+      return {allocate(n), n};
+    }
+
+    template <class... Args>
+    std::basic_string_view<Char>
+    format(fmt::basic_format_string<Char, std::type_identity_t<Args>...> f,
+           Args&&... args) {
+      using context = fmt::buffer_context<Char>;
+      return vformat(fmt::basic_string_view<Char>(f),
+                     fmt::make_format_args<context>(args...));
+    }
+  };
+
+  using text_arena = basic_text_arena<char>;
+
+  /// adopted
+  /// A renderable together with the arena holding its texts. Copies share
+  /// the arena.
+  template <line_formattable L>
+  struct adopted {
+    using char_type = typename L::char_type;
+    std::shared_ptr<const basic_text_arena<char_type>> arena{};
+    L value{};
+
+    adopted() = default;
+    adopted(std::shared_ptr<const basic_text_arena<char_type>> a, L l)
+      : arena(std::move(a)), value(std::move(l)) {}
+  };
+
+  /// @return `l` owning `arena`, whose texts `l` refers to
+  template <line_formattable L>
+  adopted<std::remove_cvref_t<L>>
+  adopt(basic_text_arena<typename std::remove_cvref_t<L>::char_type>&& arena,
+        L&& l) {
+    using Char = typename std::remove_cvref_t<L>::char_type;
+    // NOTE: the chunks are not moved, so the views in `l` remain valid
+    return {std::make_shared<const basic_text_arena<Char>>(std::move(arena)),
+            std::forward<L>(l)};
+  }
+} // namespace rich
+
+template <rich::line_formattable L, std::same_as<typename L::char_type> Char>
+struct rich::line_formatter<rich::adopted<L>, Char> : line_formatter<L, Char> {
+  explicit line_formatter(const rich::adopted<L>& a)
+    : line_formatter<L, Char>(a.value) {}
+};
+
+template <typename L, typename Char>
+struct fmt::formatter<rich::adopted<L>, Char>
+  : rich::line_formattable_default_formatter<rich::adopted<L>, Char> {};
@@ -0,0 +1,259 @@
+/// @file trace.hpp
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iterator> // std::back_inserter
+#include <memory>   // std::unique_ptr
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility> // std::exchange
+#include <vector>
+#include <fmt/format.h>
+
+// RICH_TRACE
+// Defined to 1 to record the stages of rendering as Chrome trace events.
+// Otherwise `scope` is an empty struct and costs nothing.
+#ifndef RICH_TRACE
+#define RICH_TRACE 0
+#endif
+
+#include <rich/fundamental.hpp>
+#include <rich/instrument.hpp> // rich::instrument::type_name
+
+namespace rich::trace {
+  inline constexpr bool enabled = RICH_TRACE;
+
+  /// event
+  /// A complete event. `name` and `category` must have static storage
+  /// duration.
+  struct event {
+    const char* name = nullptr;
+    const char* category = nullptr;
+    // nanoseconds since the first event of the process
+    std::uint64_t start = 0;
+    std::uint64_t duration = 0;
+  };
+
+  /// @return `name` with static storage duration, for the event of `T`
+  template <class T>
+  const char* name_of() {
+    return instrument::type_name<T>().c_str();
+  }
+
+#if RICH_TRACE
+  namespace detail {
+    inline std::atomic<bool> recording{false};
+    // pause の間はこのスレッドでは記録しない
+    inline thread_local bool paused = false;
+
+    inline std::uint64_t now() {
+      static const auto epoch = std::chrono::steady_clock::now();
+      return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - epoch)
+          .count());
+    }
+
+    // 書き込むのは所有するスレッドだけで、size の release で公開する
+    struct block_t {
+      static constexpr std::size_t capacity = 1024;
+      std::array<event, capacity> events{};
+      std::atomic<std::size_t> size{0};
+      std::atomic<block_t*> next{nullptr};
+    };
+
+    struct thread_buffer {
+      std::uint32_t tid = 0;
+      block_t head{};
+      block_t* tail = &head;
+
+      thread_buffer() = default;
+      thread_buffer(const thread_buffer&) = delete;
+      thread_buffer& operator=(const thread_buffer&) = delete;
+      ~thread_buffer() { free_blocks(); }
+
+      void push(const event& e) {
+        auto n = tail->size.load(std::memory_order_relaxed);
+        if (n == block_t::capacity) {
+          auto b = new block_t;
+          tail->next.store(b, std::memory_order_release);
+          tail = b;
+          n = 0;
+        }
+        tail->events[n] = e;
+        tail->size.store(n + 1, std::memory_order_release);
+      }
+
+      void free_blocks() {
+        for (auto b = head.next.exchange(nullptr); b != nullptr;)
+          delete std::exchange(b, b->next.load());
+        head.size = 0;
+        tail = &head;
+      }
+    };
+
+    // スレッドが終了しても記録は残す
+    struct registry_t {
+      std::mutex mtx{};
+      std::vector<std::unique_ptr<thread_buffer>> buffers{};
+
+      thread_buffer* add() {
+        std::lock_guard lock(mtx);
+        auto& buf = buffers.emplace_back(std::make_unique<thread_buffer>());
+        buf->tid = static_cast<std::uint32_t>(buffers.size());
+        return buf.get();
+      }
+    };
+
+    inline registry_t& registry() {
+      static registry_t r{};
+      return r;
+    }
+
+    inline thread_buffer& this_thread_buffer() {
+      thread_local thread_buffer* buf = registry().add();
+      return *buf;
+    }
+  } // namespace detail
+
+  /// Starts recording events.
+  inline void start() { detail::recording.store(true); }
+
+  /// Stops recording events. The events recorded so far are kept.
+  inline void stop() { detail::recording.store(false); }
+
+  /// @return whether events are being recorded on this thread
+  inline bool recording() {
+    return detail::recording.load(std::memory_order_relaxed)
+           and not detail::paused;
+  }
+
+  /// Discards the events recorded so far.
+  /// NOTE: No event may be recorded concurrently.
+  inline void clear() {
+    auto& r = detail::registry();
+    std::lock_guard lock(r.mtx);
+    for (auto& buf : r.buffers)
+      buf->free_blocks();
+  }
+
+  /// scope
+  /// Records an event lasting until the end of the scope, if recording.
+  struct scope {
+  private:
+    event e_{};
+
+  public:
+    scope(const char* name, const char* category) {
+      if (name != nullptr and recording())
+        e_ = {name, category, detail::now(), 0};
+    }
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+    ~scope() {
+      if (e_.name == nullptr)
+        return;
+      e_.duration = detail::now() - e_.start;
+      detail::this_thread_buffer().push(e_);
+    }
+  };
+
+  /// typed_scope
+  /// A scope named after `T`, whose name is only looked up when recording.
+  template <class T>
+  struct typed_scope : scope {
+    explicit typed_scope(const char* category)
+      : scope(recording() ? name_of<T>() : nullptr, category) {}
+  };
+
+  /// pause
+  /// Stops recording on this thread until the end of the scope.
+  struct pause {
+  private:
+    bool prev_;
+
+  public:
+    pause() : prev_(std::exchange(detail::paused, true)) {}
+    pause(const pause&) = delete;
+    pause& operator=(const pause&) = delete;
+    ~pause() { detail::paused = prev_; }
+  };
+
+  /// Writes the events recorded so far as Chrome trace event JSON, which
+  /// can be opened in Perfetto or chrome://tracing. Events may be recorded
+  /// concurrently.
+  template <std::output_iterator<const char&> Out>
+  Out dump_to(Out out) {
+    auto escaped = [](std::string_view s) {
+      std::string t;
+      for (const auto c : s) {
+        if (c == '"' or c == '\\')
+          t.push_back('\\');
+        t.push_back(c);
+      }
+      return t;
+    };
+    out = fmt::format_to(out, "{{\"traceEvents\":[");
+    bool first = true;
+    auto& r = detail::registry();
+    std::lock_guard lock(r.mtx);
+    for (const auto& buf : r.buffers) {
+      for (const detail::block_t* b = &buf->head; b != nullptr;
+           b = b->next.load(std::memory_order_acquire)) {
+        const auto n = b->size.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < n; ++i) {
+          const auto& e = b->events[i];
+          out = fmt::format_to(
+            out,
+            "{}\n{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{}.{:03},"
+            "\"dur\":{}.{:03},\"pid\":1,\"tid\":{}}}",
+            first ? "" : ",", escaped(e.name), escaped(e.category),
+            e.start / 1000, e.start % 1000, e.duration / 1000,
+            e.duration % 1000, buf->tid);
+          first = false;
+        }
+      }
+    }
+    return fmt::format_to(out, "\n],\"displayTimeUnit\":\"ns\"}}\n");
+  }
+#else
+  inline void start() {}
+  inline void stop() {}
+  inline bool recording() { return false; }
+  inline void clear() {}
+
+  struct scope {
+    constexpr scope(const char*, const char*) noexcept {}
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+  };
+
+  template <class T>
+  struct typed_scope {
+    constexpr explicit typed_scope(const char*) noexcept {}
+    typed_scope(const typed_scope&) = delete;
+    typed_scope& operator=(const typed_scope&) = delete;
+  };
+
+  struct pause {
+    pause() = default;
+    pause(const pause&) = delete;
+    pause& operator=(const pause&) = delete;
+  };
+
+  template <std::output_iterator<const char&> Out>
+  Out dump_to(Out out) {
+    return fmt::format_to(out, "{{\"traceEvents\":[]}}\n");
+  }
+#endif
+
+  /// @return the events recorded so far as Chrome trace event JSON
+  inline std::string dump() {
+    std::string s;
+    dump_to(std::back_inserter(s));
+    return s;
+  }
+} // namespace rich::trace
@@ -0,0 +1,127 @@
+/// @file core.cppm
+/// Partition exporting the headers directly under rich/.
+module;
+#include <rich/exception.hpp>
+#include <rich/file.hpp>
+#include <rich/follow.hpp>
+#include <rich/format.hpp>
+#include <rich/fundamental.hpp>
+#include <rich/instrument.hpp>
+#include <rich/iterator.hpp>
+#include <rich/math.hpp>
+#include <rich/parallel.hpp>
+#include <rich/ranges.hpp>
+#include <rich/regex.hpp>
+#include <rich/stacktrace.hpp>
+#include <rich/trace.hpp>
+export module rich:core;
+
+export namespace rich {
+  // exception.hpp
+  using rich::exception;
+  using rich::located_format_string;
+  using rich::runtime_error;
+
+  // file.hpp
+  using rich::extract_partial_contents;
+  using rich::find_nth;
+  using rich::get_file_contents;
+  using rich::line_index;
+
+  // follow.hpp
+  using rich::file_follower;
+
+  // format.hpp
+  using rich::align_t;
+  using rich::aligned_format_to;
+  using rich::choose_literal;
+  using rich::copy_to;
+  using rich::fill_to;
+  using rich::padded_format_to;
+  using rich::padding_size;
+  using rich::reset_style;
+  using rich::reversed_format_to;
+  using rich::set_style;
+  using rich::style_equal;
+
+  // fundamental.hpp
+  using rich::always_false;
+  using rich::contextually_convertible_to_bool;
+  using rich::icast;
+  using rich::make_reserved;
+
+  // iterator.hpp
+  using rich::counting_output;
+  using rich::erased_output;
+  using rich::null_output;
+  using rich::out;
+
+  // math.hpp
+  using rich::ilog10;
+  using rich::sat_add;
+  using rich::sat_sub;
+
+  // parallel.hpp
+  using rich::default_concurrency;
+  using rich::thread_pool;
+
+  // regex.hpp
+  using rich::match_find;
+  using rich::match_group;
+  using rich::regex_iterator;
+  using rich::regex_range;
+  using rich::regex_search;
+  using rich::to_string_view;
+
+  // stacktrace.hpp
+  using rich::frame_info;
+  using rich::stacktrace;
+  using rich::symbolize;
+  using rich::symbolize_cache_capacity;
+} // namespace rich
+
+// instrument.hpp
+export namespace rich::instrument {
+  using rich::instrument::add_escape;
+  using rich::instrument::add_padding;
+  using rich::instrument::add_set_style;
+  using rich::instrument::add_text;
+  using rich::instrument::bytes;
+  using rich::instrument::counters;
+  using rich::instrument::counting_resource;
+  using rich::instrument::enabled;
+  using rich::instrument::measure;
+  using rich::instrument::pause;
+  using rich::instrument::record_allocation;
+  using rich::instrument::replay;
+  using rich::instrument::reset;
+  using rich::instrument::scope;
+  using rich::instrument::snapshot;
+  using rich::instrument::take_snapshot;
+  using rich::instrument::type_name;
+} // namespace rich::instrument
+
+// ranges.hpp
+export namespace rich::ranges {
+  using rich::ranges::accumulate;
+  using rich::ranges::back;
+  using rich::ranges::copy;
+  using rich::ranges::front;
+  using rich::ranges::index;
+} // namespace rich::ranges
+
+// trace.hpp
+export namespace rich::trace {
+  using rich::trace::clear;
+  using rich::trace::dump;
+  using rich::trace::dump_to;
+  using rich::trace::enabled;
+  using rich::trace::event;
+  using rich::trace::name_of;
+  using rich::trace::pause;
+  using rich::trace::recording;
+  using rich::trace::scope;
+  using rich::trace::start;
+  using rich::trace::stop;
+  using rich::trace::typed_scope;
+} // namespace rich::trace
@@ -0,0 +1,23 @@
+/// @file fmt.cppm
+/// Partition exporting the part of fmt used to style and render, so that
+/// `import rich;` is enough to print a renderable.
+module;
+#include <fmt/color.h>
+#include <fmt/format.h>
+export module rich:fmt;
+
+export namespace fmt {
+  using fmt::bg;
+  using fmt::color;
+  using fmt::emphasis;
+  using fmt::fg;
+  using fmt::format;
+  using fmt::format_to;
+  using fmt::formatted_size;
+  using fmt::formatter;
+  using fmt::memory_buffer;
+  using fmt::print;
+  using fmt::terminal_color;
+  using fmt::text_style;
+  using fmt::operator|;
+} // namespace fmt
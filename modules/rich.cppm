@@ -0,0 +1,28 @@
+/// @file rich.cppm
+/// Primary module interface unit of `rich`. Importing it is equivalent to
+/// including rich/rich.hpp, except that macros are not exported.
+/// NOTE: The fmt API needed to render is exported from the `:fmt` partition.
+export module rich;
+
+export import :core;
+export import :fmt;
+export import :style.batch;
+export import :style.border;
+export import :style.box;
+export import :style.cell;
+export import :style.compact_lines;
+export import :style.enumerate;
+export import :style.format_spec;
+export import :style.hexdump;
+export import :style.line_formatter;
+export import :style.lines;
+export import :style.markup;
+export import :style.panel;
+export import :style.segment;
+export import :style.segments;
+export import :style.snapshot;
+export import :style.stacktrace;
+export import :style.static_table;
+export import :style.syntax_highlight;
+export import :style.table;
+export import :style.text_arena;
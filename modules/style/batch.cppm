@@ -0,0 +1,10 @@
+/// @file batch.cppm
+/// Partition exporting rich/style/batch.hpp.
+module;
+#include <rich/style/batch.hpp>
+export module rich:style.batch;
+
+export namespace rich {
+  using rich::batch_buffers;
+  using rich::render_batch;
+} // namespace rich
@@ -0,0 +1,12 @@
+/// @file border.cppm
+/// Partition exporting rich/style/border.hpp.
+module;
+#include <rich/style/border.hpp>
+export module rich:style.border;
+
+export namespace rich {
+  using rich::border_cache;
+  using rich::border_format_to;
+  using rich::cached_border_format_to;
+  using rich::thread_border_cache;
+} // namespace rich
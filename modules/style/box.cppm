@@ -0,0 +1,34 @@
+/// @file box.cppm
+/// Partition exporting rich/style/box.hpp.
+module;
+#include <rich/style/box.hpp>
+export module rich:style.box;
+
+export namespace rich {
+  using rich::box_t;
+  using rich::top_left;
+  using rich::top_mid;
+  using rich::top_col;
+  using rich::top_right;
+  using rich::mid_left;
+  using rich::mid_mid;
+  using rich::mid_col;
+  using rich::mid_right;
+  using rich::row_left;
+  using rich::row_mid;
+  using rich::row_col;
+  using rich::row_right;
+  using rich::bottom_left;
+  using rich::bottom_mid;
+  using rich::bottom_col;
+  using rich::bottom_right;
+} // namespace rich
+
+export namespace rich::box {
+  using rich::box::Editor;
+  using rich::box::NoBorder;
+  using rich::box::Rounded;
+  using rich::box::RoundedNoSep;
+  using rich::box::Square;
+  using rich::box::SquareNoSep;
+} // namespace rich::box
@@ -0,0 +1,19 @@
+/// @file cell.cppm
+/// Partition exporting rich/style/cell.hpp.
+module;
+#include <rich/style/cell.hpp>
+export module rich:style.cell;
+
+export namespace rich {
+  using rich::cell;
+} // namespace rich
+
+// NOTE: 特殊化は global module fragment にあり、purview から到達できない宣言
+//       は破棄されうる。テンプレートを名指しして特殊化を到達可能にする
+namespace fmt {
+  using fmt::formatter;
+} // namespace fmt
+
+namespace rich {
+  using rich::line_formatter;
+} // namespace rich
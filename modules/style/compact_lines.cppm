@@ -0,0 +1,19 @@
+/// @file compact_lines.cppm
+/// Partition exporting rich/style/compact_lines.hpp.
+module;
+#include <rich/style/compact_lines.hpp>
+export module rich:style.compact_lines;
+
+export namespace rich {
+  using rich::compact_lines;
+} // namespace rich
+
+// NOTE: 特殊化は global module fragment にあり、purview から到達できない宣言
+//       は破棄されうる。テンプレートを名指しして特殊化を到達可能にする
+namespace fmt {
+  using fmt::formatter;
+} // namespace fmt
+
+namespace rich {
+  using rich::line_formatter;
+} // namespace rich
@@ -0,0 +1,20 @@
+/// @file enumerate.cppm
+/// Partition exporting rich/style/enumerate.hpp.
+module;
+#include <rich/style/enumerate.hpp>
+export module rich:style.enumerate;
+
+export namespace rich {
+  using rich::decimal_counter;
+  using rich::enumerate;
+} // namespace rich
+
+// NOTE: 特殊化は global module fragment にあり、purview から到達できない宣言
+//       は破棄されうる。テンプレートを名指しして特殊化を到達可能にする
+namespace fmt {
+  using fmt::formatter;
+} // namespace fmt
+
+namespace rich {
+  using rich::line_formatter;
+} // namespace rich
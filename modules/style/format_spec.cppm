@@ -0,0 +1,11 @@
+/// @file format_spec.cppm
+/// Partition exporting rich/style/format_spec.hpp.
+module;
+#include <rich/style/format_spec.hpp>
+export module rich:style.format_spec;
+
+export namespace rich {
+  using rich::format_spec;
+  using rich::rspec_format_to;
+  using rich::spec_format_to;
+} // namespace rich
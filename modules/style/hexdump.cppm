@@ -0,0 +1,19 @@
+/// @file hexdump.cppm
+/// Partition exporting rich/style/hexdump.hpp.
+module;
+#include <rich/style/hexdump.hpp>
+export module rich:style.hexdump;
+
+export namespace rich {
+  using rich::hexdump;
+} // namespace rich
+
+// NOTE: 特殊化は global module fragment にあり、purview から到達できない宣言
+//       は破棄されうる。テンプレートを名指しして特殊化を到達可能にする
+namespace fmt {
+  using fmt::formatter;
+} // namespace fmt
+
+namespace rich {
+  using rich::line_formatter;
+} // namespace rich
@@ -0,0 +1,21 @@
+/// @file line_formatter.cppm
+/// Partition exporting rich/style/line_formatter.hpp.
+module;
+#include <rich/style/line_formatter.hpp>
+export module rich:style.line_formatter;
+
+export namespace rich {
+  using rich::counted_format_to;
+  using rich::fmt_iter_for;
+  using rich::format;
+  using rich::formatted_size;
+  using rich::line_format_to;
+  using rich::line_formattable;
+  using rich::line_formattable_default_formatter;
+  using rich::line_formattable_format_to;
+  using rich::line_formatted_size;
+  using rich::line_formatter;
+  using rich::line_formatter_npos;
+  using rich::npos_sub;
+  using rich::skip_lines;
+} // namespace rich
@@ -0,0 +1,25 @@
+/// @file lines.cppm
+/// Partition exporting rich/style/lines.hpp.
+module;
+#include <rich/style/lines.hpp>
+export module rich:style.lines;
+
+export namespace rich {
+  using rich::crop_line;
+  using rich::line_range;
+  using rich::lines;
+  using rich::lines_view;
+  using rich::wrap_layout;
+  using rich::wrap_line;
+  using rich::wrap_row;
+} // namespace rich
+
+// NOTE: 特殊化は global module fragment にあり、purview から到達できない宣言
+//       は破棄されうる。テンプレートを名指しして特殊化を到達可能にする
+namespace fmt {
+  using fmt::formatter;
+} // namespace fmt
+
+namespace rich {
+  using rich::line_formatter;
+} // namespace rich
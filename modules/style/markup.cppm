@@ -0,0 +1,24 @@
+/// @file markup.cppm
+/// Partition exporting rich/style/markup.hpp.
+module;
+#include <rich/style/markup.hpp>
+export module rich:style.markup;
+
+export namespace rich {
+  using rich::basic_fixed_string;
+  using rich::compile_markup;
+  using rich::compiled_markup;
+  using rich::markup_format;
+  using rich::markup_format_to;
+  using rich::markup_mode;
+  using rich::markup_segments;
+  using rich::markup_segments_to;
+  using rich::markup_string;
+  using rich::merge_style;
+  using rich::parse_markup;
+  using rich::parse_style;
+} // namespace rich
+
+export namespace rich::markup_literals {
+  using rich::markup_literals::operator""_markup;
+} // namespace rich::markup_literals
@@ -0,0 +1,19 @@
+/// @file panel.cppm
+/// Partition exporting rich/style/panel.hpp.
+module;
+#include <rich/style/panel.hpp>
+export module rich:style.panel;
+
+export namespace rich {
+  using rich::panel;
+} // namespace rich
+
+// NOTE: 特殊化は global module fragment にあり、purview から到達できない宣言
+//       は破棄されうる。テンプレートを名指しして特殊化を到達可能にする
+namespace fmt {
+  using fmt::formatter;
+} // namespace fmt
+
+namespace rich {
+  using rich::line_formatter;
+} // namespace rich
@@ -0,0 +1,17 @@
+/// @file segment.cppm
+/// Partition exporting rich/style/segment.hpp.
+module;
+#include <rich/style/segment.hpp>
+export module rich:style.segment;
+
+export namespace rich {
+  using rich::is_segment;
+  using rich::is_segment_v;
+  using rich::segment;
+} // namespace rich
+
+// NOTE: 特殊化は global module fragment にあり、purview から到達できない宣言
+//       は破棄されうる。テンプレートを名指しして特殊化を到達可能にする
+namespace fmt {
+  using fmt::formatter;
+} // namespace fmt
@@ -0,0 +1,15 @@
+/// @file segments.cppm
+/// Partition exporting rich/style/segments.hpp.
+module;
+#include <rich/style/segments.hpp>
+export module rich:style.segments;
+
+export namespace rich {
+  using rich::segments;
+} // namespace rich
+
+// NOTE: 特殊化は global module fragment にあり、purview から到達できない宣言
+//       は破棄されうる。テンプレートを名指しして特殊化を到達可能にする
+namespace fmt {
+  using fmt::formatter;
+} // namespace fmt
@@ -0,0 +1,9 @@
+/// @file snapshot.cppm
+/// Partition exporting rich/style/snapshot.hpp.
+module;
+#include <rich/style/snapshot.hpp>
+export module rich:style.snapshot;
+
+export namespace rich::instrument {
+  using rich::instrument::to_table;
+} // namespace rich::instrument
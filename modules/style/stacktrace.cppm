@@ -0,0 +1,16 @@
+/// @file stacktrace.cppm
+/// Partition exporting rich/style/stacktrace.hpp.
+/// NOTE: Only specializations are defined, so nothing is exported by name.
+module;
+#include <rich/style/stacktrace.hpp>
+export module rich:style.stacktrace;
+
+// NOTE: 特殊化は global module fragment にあり、purview から到達できない宣言
+//       は破棄されうる。テンプレートを名指しして特殊化を到達可能にする
+namespace fmt {
+  using fmt::formatter;
+} // namespace fmt
+
+namespace rich {
+  using rich::line_formatter;
+} // namespace rich
@@ -0,0 +1,19 @@
+/// @file static_table.cppm
+/// Partition exporting rich/style/static_table.hpp.
+module;
+#include <rich/style/static_table.hpp>
+export module rich:style.static_table;
+
+export namespace rich {
+  using rich::static_table;
+} // namespace rich
+
+// NOTE: 特殊化は global module fragment にあり、purview から到達できない宣言
+//       は破棄されうる。テンプレートを名指しして特殊化を到達可能にする
+namespace fmt {
+  using fmt::formatter;
+} // namespace fmt
+
+namespace rich {
+  using rich::line_formatter;
+} // namespace rich
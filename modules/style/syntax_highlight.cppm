@@ -0,0 +1,15 @@
+/// @file syntax_highlight.cppm
+/// Partition exporting rich/style/syntax_highlight.hpp.
+module;
+#include <rich/style/syntax_highlight.hpp>
+export module rich:style.syntax_highlight;
+
+export namespace rich {
+  using rich::syntax_highlight;
+  using rich::syntax_highlighter;
+  using rich::theme_t;
+} // namespace rich
+
+export namespace rich::theme {
+  using rich::theme::Default;
+} // namespace rich::theme
@@ -0,0 +1,20 @@
+/// @file table.cppm
+/// Partition exporting rich/style/table.hpp.
+module;
+#include <rich/style/table.hpp>
+export module rich:style.table;
+
+export namespace rich {
+  using rich::parallel_format_to;
+  using rich::table;
+} // namespace rich
+
+// NOTE: 特殊化は global module fragment にあり、purview から到達できない宣言
+//       は破棄されうる。テンプレートを名指しして特殊化を到達可能にする
+namespace fmt {
+  using fmt::formatter;
+} // namespace fmt
+
+namespace rich {
+  using rich::line_formatter;
+} // namespace rich
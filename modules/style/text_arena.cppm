@@ -0,0 +1,22 @@
+/// @file text_arena.cppm
+/// Partition exporting rich/style/text_arena.hpp.
+module;
+#include <rich/style/text_arena.hpp>
+export module rich:style.text_arena;
+
+export namespace rich {
+  using rich::adopt;
+  using rich::adopted;
+  using rich::basic_text_arena;
+  using rich::text_arena;
+} // namespace rich
+
+// NOTE: 特殊化は global module fragment にあり、purview から到達できない宣言
+//       は破棄されうる。テンプレートを名指しして特殊化を到達可能にする
+namespace fmt {
+  using fmt::formatter;
+} // namespace fmt
+
+namespace rich {
+  using rich::line_formatter;
+} // namespace rich
@@ -0,0 +1,5 @@
+/// @file rich.cpp
+// Defines the `char` instantiations declared in rich/style/extern_template.hpp
+// for the Iris::rich target.
+#define RICH_EXTERN_TEMPLATE template
+#include <rich/rich.hpp>
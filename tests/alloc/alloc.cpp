@@ -0,0 +1,178 @@
+#include <cstdlib> // std::malloc, std::free
+#include <iterator>
+#include <new>
+#include <string>
+#include <utility> // std::exchange
+#include <catch2/catch_test_macros.hpp>
+
+#include <rich/instrument.hpp>
+#include <rich/style.hpp>
+
+// alloc_scope
+// Counts the allocations made by the current thread while it is alive.
+// Scopes may be nested; only the innermost one counts.
+namespace {
+  thread_local std::size_t* current_count = nullptr;
+
+  void* allocate(std::size_t n, std::size_t align = 0) {
+    if (current_count != nullptr)
+      ++*current_count;
+    rich::instrument::record_allocation();
+    if (n == 0)
+      n = 1;
+    void* p = align == 0 ? std::malloc(n)
+                         : std::aligned_alloc(align, (n + align - 1) / align
+                                                       * align);
+    if (p == nullptr)
+      throw std::bad_alloc();
+    return p;
+  }
+
+  struct alloc_scope {
+  private:
+    std::size_t count_ = 0;
+    std::size_t* prev_ = nullptr;
+
+  public:
+    alloc_scope() : prev_(std::exchange(current_count, &count_)) {}
+    alloc_scope(const alloc_scope&) = delete;
+    alloc_scope& operator=(const alloc_scope&) = delete;
+    ~alloc_scope() { current_count = prev_; }
+
+    std::size_t count() const { return count_; }
+  };
+
+  // 描画済みのものを buf に描き直すときの確保の回数
+  template <class T>
+  std::size_t rerender(fmt::memory_buffer& buf, const T& x) {
+    buf.clear();
+    alloc_scope scope;
+    fmt::format_to(std::back_inserter(buf), "{}", x);
+    return scope.count();
+  }
+
+  // 一度描いて cache を温めてから数える
+  template <class T>
+  std::size_t steady_allocations(const T& x) {
+    fmt::memory_buffer buf;
+    (void)rerender(buf, x);
+    const auto expected = std::string(buf.data(), buf.size());
+    const auto n = rerender(buf, x);
+    CHECK(std::string(buf.data(), buf.size()) == expected);
+    return n;
+  }
+} // namespace
+
+// NOTE: GCC takes std::free in the replaced operator delete for a mismatch
+#if defined(__GNUC__) and not defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// clang-format off
+void* operator new(std::size_t n) { return allocate(n); }
+void* operator new[](std::size_t n) { return allocate(n); }
+void* operator new(std::size_t n, std::align_val_t a) { return allocate(n, static_cast<std::size_t>(a)); }
+void* operator new[](std::size_t n, std::align_val_t a) { return allocate(n, static_cast<std::size_t>(a)); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+// clang-format on
+
+TEST_CASE("alloc", "[alloc][scope]") {
+  alloc_scope outer;
+  {
+    alloc_scope inner;
+    auto* volatile p = new int(0);
+    delete p;
+    CHECK(inner.count() == 1);
+  }
+  CHECK(outer.count() == 0);
+  auto s = std::string(100, 'a');
+  CHECK(outer.count() == 1);
+}
+
+TEST_CASE("alloc", "[alloc][lines]") {
+  auto lns = rich::lines<char>{{"a\nbb\nccc", fg(fmt::terminal_color::blue)}};
+  CHECK(steady_allocations(lns) == 0);
+  auto highlighted = rich::lines(rich::syntax_highlight(
+    std::string_view("int main() {\n  return 0;\n}\n")));
+  CHECK(steady_allocations(highlighted) == 0);
+  auto wrapped = rich::lines<char>{{"aaa bbb ccc ddd", {}}};
+  wrapped.wrap = true;
+  auto pnl = rich::panel(wrapped);
+  pnl.contents_spec.width = 8;
+  CHECK(steady_allocations(pnl) == 0);
+}
+
+TEST_CASE("alloc", "[alloc][enumerate]") {
+  auto lns = rich::lines<char>{{"a\nbb\nccc", fg(fmt::terminal_color::blue)}};
+  CHECK(steady_allocations(rich::enumerate(lns)) == 0);
+  auto pnl = rich::panel(rich::enumerate(lns));
+  CHECK(steady_allocations(pnl) == 0);
+}
+
+namespace {
+  rich::lines<char> many_lines(const std::string& text) {
+    return rich::lines<char>{{text, fg(fmt::terminal_color::blue)}};
+  }
+  const std::string many_text = [] {
+    std::string s;
+    for (std::size_t i = 0; i < 300; ++i)
+      s += "line\n";
+    return s;
+  }();
+} // namespace
+
+TEST_CASE("alloc", "[alloc][panel]") {
+  auto lns = rich::lines<char>{{"a\nbb\nccc", fg(fmt::terminal_color::blue)}};
+  auto pnl = rich::panel(lns);
+  CHECK(steady_allocations(pnl) == 0);
+  pnl.contents_spec.width = 4; // crop
+  CHECK(steady_allocations(pnl) == 0);
+
+  // 入れ子の panel は枠の文字列を一度だけ確保する
+  auto many = many_lines(many_text);
+  auto inner = rich::panel(lns);
+  auto outer = rich::panel<decltype(inner)>(inner);
+  auto inner2 = rich::panel(many);
+  auto outer2 = rich::panel<decltype(inner2)>(inner2);
+  const auto n = steady_allocations(outer);
+  CHECK(n <= 2);
+  CHECK(steady_allocations(outer2) == n);
+}
+
+TEST_CASE("alloc", "[alloc][table]") {
+  auto few = rich::lines<char>{{"a\nbb\nccc", fg(fmt::terminal_color::blue)}};
+  auto many = many_lines(many_text);
+
+  // line_formatter<cell> の複製のほかは確保しない
+  auto small = rich::table(few, rich::enumerate(few), rich::panel(few));
+  auto large = rich::table(many, rich::enumerate(many), rich::panel(many));
+  const auto n = steady_allocations(small);
+  CHECK(n <= 1 + small.size());
+  CHECK(steady_allocations(large) == n);
+
+  auto fixed = rich::static_table(few, rich::enumerate(few));
+  CHECK(steady_allocations(fixed) == 0);
+  auto fused = rich::static_table(few, rich::panel(few));
+  auto fused2 = rich::static_table(many, rich::panel(many));
+  const auto m = steady_allocations(fused);
+  CHECK(m <= 2);
+  CHECK(steady_allocations(fused2) == m);
+}
+
+TEST_CASE("alloc", "[alloc][hexdump]") {
+  std::string bytes;
+  for (std::size_t i = 0; i < 4096; ++i)
+    bytes.push_back(static_cast<char>(i));
+  // 1 行分の変換は stack で足りる
+  auto hd = rich::hexdump(bytes);
+  CHECK(steady_allocations(hd) == 0);
+  hd.bytes_per_line = 32;
+  CHECK(steady_allocations(hd) == 0);
+}
@@ -1,9 +1,13 @@
 #include <catch2/catch_test_macros.hpp>
 
 #include <iostream>
+#include <list>
 #include <rich/exception.hpp>
 #include <rich/file.hpp>
+#include <rich/format.hpp>
+#include <rich/math.hpp>
 #include <rich/regex.hpp>
+#include <rich/style/stacktrace.hpp>
 
 inline constexpr std::string_view hline =
   "============================================================================"
@@ -157,4 +161,170 @@ TEST_CASE("main", "[main][regex]") {
   }
 }
 
+TEST_CASE("main", "[main][fill_to]") {
+  std::string_view glyph = "─";
+  for (std::size_t n : {0u, 1u, 2u, 3u, 7u, 80u}) {
+    std::string expected;
+    for (std::size_t i = 0; i < n; ++i)
+      expected += glyph;
+    { // pointer
+      std::string str(expected.size(), '\0');
+      auto last = rich::fill_to<char>(str.data(), glyph, n);
+      CHECK(last == str.data() + str.size());
+      CHECK(str == expected);
+    }
+    { // back inserter of contiguous container
+      std::string str = "+";
+      rich::fill_to<char>(std::back_inserter(str), glyph, n);
+      CHECK(str == "+" + expected);
+    }
+    { // fmt buffer
+      fmt::memory_buffer buf;
+      fmt::format_to(fmt::appender(buf), "+");
+      rich::fill_to<char>(fmt::appender(buf), glyph, n);
+      CHECK(fmt::to_string(buf) == "+" + expected);
+    }
+    { // generic output iterator
+      std::list<char> lst;
+      rich::fill_to<char>(std::back_inserter(lst), glyph, n);
+      CHECK(std::string(lst.begin(), lst.end()) == expected);
+    }
+  }
+}
+
+TEST_CASE("main", "[main][ilog10]") {
+  CHECK(rich::ilog10(0u) == 0);
+  CHECK(rich::ilog10(1u) == 0);
+  CHECK(rich::ilog10(9u) == 0);
+  CHECK(rich::ilog10(10u) == 1);
+  CHECK(rich::ilog10(99u) == 1);
+  CHECK(rich::ilog10(100u) == 2);
+  CHECK(rich::ilog10(999u) == 2);
+  CHECK(rich::ilog10(1000u) == 3);
+  CHECK(rich::ilog10(std::size_t(-1)) == 19);
+}
+
+TEST_CASE("main", "[main][line_index]") {
+  {
+    std::string_view sv = "ab\ncd\n\nef";
+    rich::line_index index(sv);
+    REQUIRE(index.size() == 4);
+    CHECK(index.line(0) == "ab");
+    CHECK(index.line(1) == "cd");
+    CHECK(index.line(2) == "");
+    CHECK(index.line(3) == "ef");
+    CHECK(index.line(4) == "");
+    CHECK(index.slice(1, 3) == "cd\n");
+    CHECK(index.slice(1, 4) == "cd\n\nef");
+    CHECK(index.slice(0, 100) == sv);
+    CHECK(index.slice(3, 1) == "");
+  }
+  {
+    std::string_view sv = "ab\n";
+    rich::line_index index(sv);
+    REQUIRE(index.size() == 2);
+    CHECK(index.line(0) == "ab");
+    CHECK(index.line(1) == "");
+  }
+}
+
+[[gnu::noinline]] void throw_nested(int depth) {
+  if (depth == 0)
+    throw rich::runtime_error("nested");
+  throw_nested(depth - 1);
+}
+
+TEST_CASE("main", "[main][stacktrace]") {
+  {
+    rich::stacktrace::enable(false);
+    try {
+      throw_nested(0);
+    } catch (const rich::exception& e) { CHECK(e.trace() == nullptr); }
+  }
+#if RICH_HAS_STACKTRACE
+  {
+    rich::stacktrace::enable();
+    try {
+      throw_nested(3);
+    } catch (const rich::exception& e) {
+      const auto* st = e.trace();
+      REQUIRE(st != nullptr);
+      CHECK(st->size() > 4);
+      const auto fi = st->frame(0);
+      CHECK(fi.address == (*st)[0]);
+      const auto cached = rich::symbolize((*st)[0]);
+      CHECK(cached.function == fi.function);
+      CHECK(cached.offset == fi.offset);
+      const auto s = fmt::format("{}", *st);
+      CHECK(s.find("#0 ") != std::string::npos);
+      CHECK(s.find("#4 ") != std::string::npos);
+    }
+    rich::stacktrace::enable(false);
+  }
+  {
+    // cache の大きさは capacity を超えない
+    const char bytes[rich::symbolize_cache_capacity + 1] = {};
+    for (const auto& b : bytes)
+      (void)rich::symbolize(&b);
+    auto& cache = rich::detail::get_symbolize_cache();
+    std::lock_guard lock(cache.mtx);
+    CHECK(cache.map.size() <= rich::symbolize_cache_capacity);
+  }
+#endif
+}
+
+TEST_CASE("main", "[main][exception_message]") {
+  {
+    rich::runtime_error e("literal message");
+    CHECK(std::string_view(e.what()) == "literal message");
+    CHECK(e.where().line() == __LINE__ - 2);
+    rich::runtime_error copy(e);
+    CHECK(copy.what() == e.what());
+  }
+  { // 引数のない文字列リテラルは書式文字列として扱わない
+    rich::runtime_error e("use {x} or {{}}");
+    CHECK(std::string_view(e.what()) == "use {x} or {{}}");
+    rich::runtime_error e2("escaped {{}}: {}", 1);
+    CHECK(std::string_view(e2.what()) == "escaped {}: 1");
+  }
+  { // 呼び出し元の位置を明示する
+    const auto loc = std::source_location::current();
+    rich::runtime_error e("located {literal}", loc);
+    CHECK(std::string_view(e.what()) == "located {literal}");
+    CHECK(e.where().line() == loc.line());
+    rich::runtime_error e2(std::string("located runtime"), loc);
+    CHECK(e2.where().line() == loc.line());
+  }
+  {
+    rich::runtime_error e("{} / {} = {:.1f}", 3, 2, 1.5);
+    rich::runtime_error copy(e);
+    CHECK(std::string_view(e.what()) == "3 / 2 = 1.5");
+    CHECK(std::string_view(copy.what()) == "3 / 2 = 1.5");
+    CHECK(e.what() == e.what());
+    rich::runtime_error shared(e);
+    CHECK(shared.what() == e.what());
+  }
+  {
+    std::string name = "file.txt";
+    rich::runtime_error e("Failed to read {}", name);
+    name.clear();
+    CHECK(std::string_view(e.what()) == "Failed to read file.txt");
+    rich::runtime_error copy("");
+    copy = e;
+    CHECK(copy.what() == e.what());
+  }
+  {
+    const std::string msg = "runtime message";
+    rich::runtime_error e(msg);
+    CHECK(std::string_view(e.what()) == msg);
+    const char* p = msg.c_str();
+    rich::runtime_error e2(p);
+    CHECK(std::string_view(e2.what()) == msg);
+    char buf[32] = "runtime {buffer}";
+    rich::runtime_error e3(buf);
+    buf[0] = '\0';
+    CHECK(std::string_view(e3.what()) == "runtime {buffer}");
+  }
+}
+
 // TEST_CASE("main", "[main][squared]") {}
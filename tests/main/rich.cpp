@@ -0,0 +1,3 @@
+// Includes every header in a second translation unit of main_tests, so that
+// a non-inline function defined in a header fails to link.
+#include <rich/rich.hpp>
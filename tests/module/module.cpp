@@ -0,0 +1,16 @@
+#include <string>
+#include <string_view>
+#include <catch2/catch_test_macros.hpp>
+
+import rich;
+
+TEST_CASE("module", "[module][import]") {
+  auto lns = rich::lines<char>{{"a\nbb\nccc", fg(fmt::terminal_color::blue)}};
+  rich::enumerate numbered(lns);
+  rich::table tbl(lns, numbered, rich::panel(lns));
+  tbl.title = std::string_view("title");
+  const auto str = fmt::format("{}", tbl);
+  CHECK(str.find("title") != std::string::npos);
+  CHECK(str.find("ccc") != std::string::npos);
+  CHECK(rich::sat_add(std::size_t(-1), 1) == std::size_t(-1));
+}
@@ -1,7 +1,12 @@
-#include <ranges> // std::views::transform
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource> // std::pmr::monotonic_buffer_resource
+#include <ranges>          // std::views::transform
 #include <catch2/catch_test_macros.hpp>
 
 #include <rich/file.hpp>
+#include <rich/follow.hpp>
 #include <rich/regex.hpp>
 #include <rich/style.hpp>
 
@@ -10,6 +15,10 @@ inline constexpr std::string_view hline =
   "===";
 
 static_assert(std::output_iterator<rich::erased_output<char>, const char&>);
+static_assert(std::output_iterator<rich::null_output, const char&>);
+static_assert(std::output_iterator<rich::counting_output, const char&>);
+// RICH_INSTRUMENT によらず Iris::rich と同じ layout になる
+static_assert(sizeof(rich::instrument::bytes) == 4 * sizeof(std::uint64_t));
 
 TEST_CASE("style", "[style][segment]") {
   std::string_view orig("01234567890123456789");
@@ -186,4 +195,831 @@ TEST_CASE("style", "[style]") {
     } */
   }
 }
+TEST_CASE("style", "[style][lines]") {
+  { // line_width, max_width
+    auto sv = std::string_view("Hello\nworld!\n\nfoo");
+    auto lns = rich::lines<char>{{sv.substr(0, 8), {}}, {sv.substr(8), {}}};
+    REQUIRE(lns.size() == 4);
+    CHECK(lns.line_width(0) == 5);
+    CHECK(lns.line_width(1) == 6);
+    CHECK(lns.line_width(2) == 0);
+    CHECK(lns.line_width(3) == 3);
+    CHECK(lns.max_width() == 6);
+    CHECK(std::ranges::size(lns[1]) == 2);
+  }
+  { // random access
+    auto lns = rich::lines<char>{{"a\nbb\nccc\ndddd\neeeee", {}}};
+    static_assert(std::ranges::random_access_range<decltype(lns)>);
+    static_assert(std::ranges::sized_range<decltype(lns)>);
+    auto rev = lns | std::views::reverse | std::views::take(2);
+    CHECK((*std::ranges::begin(rev))[0].text() == "eeeee");
+    CHECK(std::ranges::begin(lns)[2][0].text() == "ccc");
+    CHECK(std::ranges::end(lns) - std::ranges::begin(lns) == 5);
+    // subrange, tail
+    auto sub = lns.subrange(1, 2);
+    static_assert(std::ranges::random_access_range<decltype(sub)>);
+    CHECK(sub.size() == 2);
+    CHECK(sub.line_width(1) == 3);
+    CHECK(rich::format(sub) == rich::format(rich::lines<char>{{"bb\nccc", {}}}));
+    CHECK(rich::format(lns.tail(2))
+          == rich::format(rich::lines<char>{{"dddd\neeeee", {}}}));
+    CHECK(lns.tail(10).size() == 5);
+    CHECK(lns.subrange(10).empty());
+    CHECK(rich::format(rich::panel(lns.tail(1)))
+          == rich::format(rich::panel(rich::lines<char>{{"eeeee", {}}})));
+  }
+  { // empty
+    auto lns = rich::lines<char>();
+    CHECK(lns.size() == 0);
+    CHECK(lns.max_width() == 0);
+  }
+}
+TEST_CASE("style", "[style][pmr]") {
+  // Every allocation must be served by the arena; the upstream throws.
+  std::array<std::byte, 1 << 14> buf;
+  std::pmr::monotonic_buffer_resource mr(buf.data(), buf.size(),
+                                         std::pmr::null_memory_resource());
+  auto sv = std::string_view("Hello\nworld!");
+  std::string expected, actual;
+  {
+    auto lns = rich::lines<char>{{sv, {}}};
+    expected = fmt::format("{}", rich::table(lns, lns));
+  }
+  {
+    auto lns =
+      rich::lines<char>(std::allocator_arg, &mr, {{sv, {}}}, 0, false);
+    CHECK(lns.get_allocator().resource() == &mr);
+    auto tbl = rich::table<char>(std::allocator_arg, &mr, lns, lns);
+    CHECK(tbl.get_allocator().resource() == &mr);
+    auto out = fmt::memory_buffer();
+    fmt::format_to(std::back_inserter(out), "{}", tbl);
+    actual = fmt::to_string(out);
+  }
+  CHECK(expected == actual);
+}
+TEST_CASE("style", "[style][formatted_size]") {
+  auto sv = std::string_view("Hello\nworld!");
+  auto lns = rich::lines<char>{{sv, fg(fmt::terminal_color::red)}};
+  auto check = [](const auto& l) {
+    const auto str = fmt::format("{}", l);
+    CHECK(rich::formatted_size(l) == str.size());
+    CHECK(rich::format(l) == str);
+  };
+  check(lns);
+  check(rich::panel(lns));
+  check(rich::enumerate(lns));
+  check(rich::table(lns, rich::panel(lns)));
+  { // width
+    auto pnl = rich::panel(lns);
+    CHECK(rich::formatted_size(pnl, 20) == rich::format(pnl, 20).size());
+    CHECK(rich::formatted_size(pnl, 20) < rich::formatted_size(pnl));
+  }
+}
+TEST_CASE("style", "[style][border]") {
+  rich::box_t<char> box = rich::box::Rounded<char>;
+  auto bs = rich::panel<rich::lines<char>>().border_spec;
+  auto render = [&](std::string_view title, std::size_t width) {
+    std::string str;
+    rich::border_format_to<char>(std::back_inserter(str), bs,
+                                 rich::top_left(box), rich::top_mid(box),
+                                 rich::top_right(box), title, width);
+    return str;
+  };
+  auto& cache = rich::thread_border_cache<char>();
+  auto get = [&](std::string_view title, std::size_t width) {
+    return std::string(cache.get(bs, rich::top_left(box), rich::top_mid(box),
+                                 rich::top_right(box), title, width));
+  };
+  CHECK(get("title", 20) == render("title", 20));
+  CHECK(get("title", 20) == render("title", 20));
+  CHECK(get("other", 20) == render("other", 20));
+  CHECK(get("title", 30) == render("title", 30));
+  bs.style = fg(fmt::terminal_color::blue);
+  CHECK(get("title", 20) == render("title", 20));
+}
+TEST_CASE("style", "[style][decimal_counter]") {
+  for (std::size_t n : {0u, 1u, 8u, 9u, 99u, 998u, 1000u}) {
+    rich::decimal_counter<char> counter(n);
+    for (std::size_t i = n; i < n + 3; ++i, ++counter)
+      CHECK(counter.view() == fmt::format("{}", i));
+  }
+  { // enumerate
+    auto lns = rich::lines<char>{{"a\nb\nc\nd\ne\nf", {}}};
+    auto enm = rich::enumerate(lns);
+    enm.start_line = 8;
+    enm.end_line = 13;
+    enm.number_spec.style = {};
+    using namespace std::string_view_literals;
+    CHECK(rich::format(enm) == "\0 8 a\n 9 b\n10 c\n11 d\n12 e\n13 f"sv);
+  }
+}
+TEST_CASE("style", "[style][enumerate]") {
+  { // visible window
+    auto lns = rich::lines<char>{{"a\nb\nc\nd\ne\nf", {}}};
+    auto enm = rich::enumerate(lns);
+    enm.start_line = 8;
+    enm.end_line = 13;
+    enm.number_spec.style = {};
+    enm.visible_first = 9;
+    enm.visible_last = 12;
+    using namespace std::string_view_literals;
+    CHECK(rich::format(enm) == "\0 9 b\n10 c\n11 d"sv);
+  }
+  { // visible window without `skip`
+    auto lns = rich::lines<char>{{"a\nb\nc\nd\ne\nf", {}}};
+    auto pnl = rich::panel(lns);
+    pnl.contents_spec = {.fill = " ", .width = 5};
+    pnl.border_spec = {.fill = " ", .width = 1};
+    pnl.nomatter = true;
+    auto enm = rich::enumerate(pnl);
+    enm.visible_first = 4;
+    enm.number_spec.style = {};
+    using namespace std::string_view_literals;
+    CHECK(rich::format(enm) == "\0" "4 │d  │\n5 │e  │\n6 │f  │"sv);
+  }
+}
+TEST_CASE("style", "[style][follow]") {
+  const auto path =
+    (std::filesystem::temp_directory_path() / "rich_follow_test.log").string();
+  std::ofstream ofs(path, std::ios::trunc);
+  ofs << "int a = 1;\nint b" << std::flush;
+
+  rich::file_follower follower(path, 1);
+  std::vector<std::pair<std::string, std::size_t>> flushed;
+  auto f = [&](const auto& lns, std::size_t first_line) {
+    auto enm = rich::enumerate(lns);
+    enm.start_line = enm.end_line = first_line;
+    flushed.emplace_back(fmt::format("{}", enm), first_line);
+  };
+  CHECK(follower.flush(f) == 1);
+  CHECK(follower.flush(f) == 0);
+
+  ofs << " = 2;\nint c = 3;\n// tail" << std::flush;
+  follower.wait(std::chrono::milliseconds(100));
+  CHECK(follower.read_appended() == 24);
+  CHECK(follower.index().size() == 3);
+  CHECK(follower.flush(f) == 2);
+  REQUIRE(flushed.size() == 2);
+  CHECK(flushed[0].second == 1);
+  CHECK(flushed[1].second == 2);
+  // flush した行は捨てる
+  CHECK(follower.pending() == "// tail");
+  fmt::print("{}\n{}\n{}\n", hline, flushed[0].first, flushed[1].first);
+
+  // 既定では末尾から追う
+  rich::file_follower eof(path);
+  CHECK(eof.pending().empty());
+  CHECK(eof.flush(f) == 0);
+  // 行数より大きい tail はファイル全体
+  CHECK(rich::file_follower(path, 10).index().size() == 4);
+
+  // truncate されたら先頭から読み直す
+  ofs.close();
+  std::ofstream(path, std::ios::trunc) << "x\n" << std::flush;
+  follower.wait(std::chrono::milliseconds(100));
+  CHECK(follower.read_appended() == 2);
+  flushed.clear();
+  CHECK(follower.flush(f) == 2); // "// tail" と "x"
+  REQUIRE(flushed.size() == 1);
+  CHECK(flushed[0].second == 4);
+  CHECK(follower.pending().empty());
+
+  // rotation: 古いファイルの残りを読んでから新しいファイルを開く
+  const auto rotated = path + ".1";
+  std::ofstream(path, std::ios::app) << "y\n" << std::flush;
+  std::filesystem::rename(path, rotated);
+  follower.wait(std::chrono::milliseconds(100));
+  std::ofstream(path) << "z\n" << std::flush;
+  CHECK(follower.read_appended() == 4);
+  CHECK(follower.flush(f) == 2);
+  CHECK(follower.index().text().empty());
+  std::ofstream(path, std::ios::app) << "w\n" << std::flush;
+  CHECK(follower.wait(std::chrono::milliseconds(100)));
+  CHECK(follower.read_appended() == 2);
+  CHECK(follower.flush(f) == 1);
+  CHECK(flushed.back().second == 8);
+  std::filesystem::remove(rotated);
+  std::filesystem::remove(path);
+}
+TEST_CASE("style", "[style][parallel]") {
+  rich::thread_pool pool(4);
+  CHECK(pool.size() == 4);
+  {
+    std::vector<std::size_t> squares(1000), expected(1000);
+    std::atomic<std::size_t> max_worker = 0;
+    pool.parallel_for(squares.size(), [&](std::size_t i, std::size_t worker) {
+      squares[i] = i * i;
+      for (auto w = max_worker.load(); w < worker;)
+        max_worker.compare_exchange_weak(w, worker);
+    });
+    for (std::size_t i = 0; i < expected.size(); ++i)
+      expected[i] = i * i;
+    CHECK(squares == expected);
+    CHECK(max_worker < pool.size());
+  }
+  CHECK_THROWS_AS(pool.parallel_for(10,
+                                    [](std::size_t i, std::size_t) {
+                                      if (i == 5)
+                                        throw rich::runtime_error("five");
+                                    }),
+                  rich::runtime_error);
+
+  auto lns = rich::lines<char>{{"a\nbb\nccc", fg(fmt::terminal_color::blue)}};
+  auto empty = rich::lines<char>{{"", {}}};
+  auto render = [&](const rich::table<char>& tbl) {
+    std::string str;
+    rich::parallel_format_to(std::back_inserter(str), tbl, pool);
+    return str;
+  };
+  {
+    auto tbl = rich::table<char>();
+    for (std::size_t i = 0; i < 200; ++i) {
+      if (i % 3 == 0)
+        tbl.push_back(rich::enumerate(lns));
+      else if (i % 3 == 1)
+        tbl.push_back(rich::panel(lns));
+      else
+        tbl.push_back(empty);
+    }
+    tbl.title = "title";
+    CHECK(render(tbl) == fmt::format("{}", tbl));
+    tbl.nomatter = true;
+    CHECK(render(tbl) == fmt::format("{}", tbl));
+    tbl.push_back(lns);
+    CHECK(render(tbl) == fmt::format("{}", tbl));
+  }
+  {
+    auto tbl = rich::table(empty, empty);
+    tbl.nomatter = true;
+    CHECK(render(tbl) == fmt::format("{}", tbl));
+    tbl.nomatter = false;
+    CHECK(render(tbl) == fmt::format("{}", tbl));
+  }
+}
+
+TEST_CASE("style", "[style][batch]") {
+  rich::thread_pool pool(4);
+  auto lns = rich::lines<char>{{"a\nbb\nccc", fg(fmt::terminal_color::blue)}};
+  std::vector<rich::cell<char>> items;
+  for (std::size_t i = 0; i < 100; ++i) {
+    if (i % 2 == 0)
+      items.emplace_back(rich::panel(lns));
+    else
+      items.emplace_back(lns);
+  }
+  for (int round = 0; round < 2; ++round) {
+    std::string out;
+    const auto offsets = rich::render_batch(
+      std::span<const rich::cell<char>>(items),
+      [&out](std::string_view sv) { out.append(sv); }, pool);
+    REQUIRE(offsets.size() == items.size() + 1);
+    CHECK(offsets.back() == out.size());
+    for (std::size_t i = 0; i < items.size(); ++i)
+      CHECK(out.substr(offsets[i], offsets[i + 1] - offsets[i])
+            == fmt::format("{}", items[i]));
+  }
+  { // 呼び出し側の buffer を使い回す
+    rich::batch_buffers<char> bufs;
+    std::string out, out2;
+    (void)rich::render_batch(
+      std::span<const rich::cell<char>>(items),
+      [&out](std::string_view sv) { out.append(sv); }, pool, bufs);
+    CHECK(bufs.buffers.size() == pool.size());
+    (void)rich::render_batch(
+      std::span<const rich::cell<char>>(items),
+      [&out2](std::string_view sv) { out2.append(sv); }, pool, bufs);
+    CHECK(out2 == out);
+    bufs.shrink();
+    for (const auto& buf : bufs.buffers)
+      CHECK(buf.capacity() == fmt::inline_buffer_size);
+  }
+}
+
+TEST_CASE("style", "[style][markup]") {
+  using namespace rich::markup_literals;
+  using namespace std::string_view_literals;
+  const auto red = fg(fmt::terminal_color::red);
+  const auto bold = fmt::text_style(fmt::emphasis::bold);
+  auto styled = [](std::string_view sv, const fmt::text_style& style) {
+    return fmt::format("{}", rich::segment<char>(sv, style));
+  };
+  {
+    static constexpr auto m = "[bold red]error[/] at {}"_markup;
+    static_assert(m.pieces.size() == 2);
+    static_assert(m.styles.size() == 2);
+    static_assert(m.text_of(m.pieces[1]) == " at {0}");
+    CHECK(rich::markup_format(m, 42)
+          == styled("error", bold | red) + styled(" at 42", {}));
+    const auto segs = m.to_segments();
+    CHECK(segs[0].text() == "error");
+    CHECK(rich::style_equal(segs[0].style(), bold | red));
+  }
+  { // nesting, escapes and interned styles
+    static constexpr auto m =
+      "[red]a[bold]b[/bold]c\\\\[/red] \\[x] [0] {{}} {:>3}"_markup;
+    static_assert(m.styles.size() == 3);
+    static_assert(m.pieces.size() == 4);
+    CHECK(rich::markup_format(m, 7)
+          == styled("a", red) + styled("b", bold | red) + styled("c\\", red)
+               + styled(" [x] [0] {}   7", {}));
+  }
+  { // inner colors take precedence
+    static constexpr auto m = "[red on white][blue]x[/][/]"_markup;
+    CHECK(rich::style_equal(
+      m.styles[m.pieces[0].style],
+      fg(fmt::terminal_color::blue) | bg(fmt::terminal_color::white)));
+  }
+  { // rgb
+    static constexpr auto m = "[#ff8800]x[/]"_markup;
+    CHECK(rich::style_equal(m.styles[m.pieces[0].style], fg(fmt::rgb(0xff8800))));
+  }
+  { // 置換フィールドは引数の型とコンパイル時に照合される
+    static constexpr auto m = "[red]{:d}[/] {:>{}}"_markup;
+    static_assert(rich::detail::check_markup_fields<char, "[red]{:d}[/] {:>{}}",
+                                                    int, std::string, int>());
+    CHECK(rich::markup_format(m, 1, std::string("ab"), 3)
+          == styled("1", red) + styled("  ab", {}));
+    // NOTE: rich::markup_format(m, "1", ...) does not compile
+  }
+}
+
+TEST_CASE("style", "[style][markup_segments]") {
+  const auto red = fg(fmt::terminal_color::red);
+  const auto bold = fmt::text_style(fmt::emphasis::bold);
+  {
+    const std::string markup = "[red]a[bold]b\\[c[/bold]d[/] e[0]";
+    const auto segs = rich::markup_segments<char>(markup);
+    REQUIRE(segs.size() == 5);
+    CHECK(segs[0].text() == "a");
+    CHECK(rich::style_equal(segs[0].style(), red));
+    CHECK(segs[1].text() == "b");
+    CHECK(segs[2].text() == "[c");
+    CHECK(rich::style_equal(segs[2].style(), bold | red));
+    CHECK(segs[3].text() == "d");
+    CHECK(rich::style_equal(segs[3].style(), red));
+    CHECK(segs[4].text() == " e[0]");
+    CHECK(rich::style_equal(segs[4].style(), {}));
+    // zero-copy
+    for (const auto& seg : segs) {
+      CHECK(markup.data() <= seg.text().data());
+      CHECK(seg.text().data() + seg.text().size()
+            <= markup.data() + markup.size());
+    }
+    auto lns = rich::lines<char>(segs);
+    CHECK(lns.size() == 1);
+  }
+  { // malformed
+    auto parse = [](std::string_view sv) {
+      return rich::markup_segments<char>(sv);
+    };
+    CHECK_THROWS_AS(parse("[red"), rich::runtime_error);
+    CHECK_THROWS_AS(parse("a[/]"), rich::runtime_error);
+    CHECK_THROWS_AS(parse("[red]a[/bold]"), rich::runtime_error);
+    CHECK_THROWS_AS(parse("[redd]a"), rich::runtime_error);
+    CHECK_THROWS_AS(parse("[on]a"), rich::runtime_error);
+    try {
+      parse("[red]a[/bold]");
+    } catch (const rich::exception& e) {
+      CHECK(std::string_view(e.what())
+            == "Mismatched closing markup tag at offset 6");
+    }
+    // 閉じていないタグは開いた位置で報告する
+    CHECK_THROWS_AS(parse("[red]a"), rich::runtime_error);
+    try {
+      parse("x[red]a[bold]b[/bold]");
+    } catch (const rich::exception& e) {
+      CHECK(std::string_view(e.what()) == "Unclosed markup tag at offset 1");
+    }
+  }
+  { // lenient: 不正なタグはそのまま表示し、開いたタグは最後に閉じる
+    auto text = [](std::string_view sv) {
+      std::string str;
+      for (const auto& seg : rich::markup_segments<char>(
+             sv, rich::markup_mode::lenient))
+        str += seg.text();
+      return str;
+    };
+    CHECK(text("a[i]") == "a[i]");
+    CHECK(text("see [note] and [red") == "see [note] and [red");
+    CHECK(text("a[/] [/red]") == "a[/] [/red]");
+    CHECK(text("[on]a") == "[on]a");
+    const auto segs = rich::markup_segments<char>("[red]a[x]b[/bold]",
+                                                  rich::markup_mode::lenient);
+    REQUIRE(segs.size() == 1);
+    CHECK(segs[0].text() == "a[x]b[/bold]");
+    CHECK(rich::style_equal(segs[0].style(), red));
+    CHECK(text("[a[red]b[/]") == "[ab");
+    // 閉じていないタグが多くても線形時間
+    std::string unclosed;
+    for (int i = 0; i < 200000; ++i)
+      unclosed += "[a";
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(text(unclosed) == unclosed);
+    CHECK(text(unclosed + "]") == unclosed + "]");
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+  }
+}
+
+TEST_CASE("style", "[style][wrap]") {
+  auto rows = [](std::string_view sv, std::size_t width) {
+    std::vector<std::string_view> v;
+    std::vector<rich::wrap_row> rs;
+    rich::wrap_line(std::back_inserter(rs),
+                    std::array{rich::segment<char>(sv)}, width);
+    for (const auto& r : rs)
+      v.push_back(sv.substr(r.first, r.last - r.first));
+    return v;
+  };
+  using v = std::vector<std::string_view>;
+  CHECK(rows("", 4) == v{""});
+  CHECK(rows("abc", 4) == v{"abc"});
+  CHECK(rows("ab cd ef", 5) == v{"ab cd", "ef"});
+  CHECK(rows("ab   cd", 4) == v{"ab", "cd"});
+  CHECK(rows("ab cd  ", 5) == v{"ab cd"});
+  CHECK(rows("abcdefgh ij", 3) == v{"abc", "def", "gh", "ij"});
+  CHECK(rows("  indented text", 10) == v{"  indented", "text"});
+  CHECK(rows("aaaa bbbb", 4) == v{"aaaa", "bbbb"});
+
+  const auto red = fg(fmt::terminal_color::red);
+  auto lns =
+    rich::lines<char>{{"Division ", {}}, {"by zero", red}, {"\nok", {}}};
+  lns.wrap = true;
+  auto layout = lns.layout(6);
+  CHECK(layout == lns.layout(6)); // cached per width
+  CHECK(layout->firsts == std::pmr::vector<std::size_t>{0, 3, 4});
+  auto pnl = rich::panel(lns);
+  pnl.contents_spec.width = 10;
+  pnl.contents_spec.style = {};
+  pnl.border_spec.style = {};
+  pnl.border_spec.width = 2;
+  using namespace std::string_literals;
+  auto by = fmt::format("{}", rich::segment<char>("by", red));
+  auto zero = fmt::format("{}", rich::segment<char>("zero", red));
+  auto expected = "\0╭────────╮\n│ Divisi │\n│ on "s + by + "  │\n│ " + zero
+                  + "   │\n│ ok     │\n╰────────╯";
+  CHECK(fmt::format("{}", pnl) == expected);
+  CHECK(fmt::format("{}", pnl) == expected);
+  CHECK(layout != lns.layout(5));
+
+  { // 折り返した行の続きには行番号を付けず、幅を揃える
+    auto words = rich::lines<char>{{"one two three four five\nsix", {}}};
+    words.wrap = true;
+    auto enm = rich::enumerate(words);
+    enm.end_line = 2;
+    enm.number_spec.style = {};
+    auto pnl2 = rich::panel(enm);
+    pnl2.contents_spec.width = 10;
+    pnl2.contents_spec.style = {};
+    pnl2.border_spec.style = {};
+    pnl2.border_spec.width = 2;
+    CHECK(fmt::format("{}", pnl2)
+          == "\0╭────────╮\n│ 1 one  │\n│   two  │\n│   thre │\n"
+             "│   e    │\n│   four │\n│   five │\n│ 2 six  │\n╰────────╯"s);
+    enm.visible_last = 2;
+    CHECK(rich::format(enm, 8)
+          == "\0" "1 one\n  two\n  three\n  four\n  five"s);
+  }
+}
+
+TEST_CASE("style", "[style][compact_lines]") {
+  const std::string contents = "int main() {\n  return 0;\n}\n";
+  auto highlighted = rich::syntax_highlight(contents);
+  auto lns = rich::lines(highlighted);
+  auto compact = rich::compact_lines<char>(contents, lns);
+  REQUIRE(compact.size() == lns.size());
+  CHECK(compact.max_width() == lns.max_width());
+  CHECK(compact.style_count() < 16);
+  CHECK(fmt::format("{}", compact) == fmt::format("{}", lns));
+  CHECK(fmt::format("{}", rich::compact_lines<char>(contents, highlighted))
+        == fmt::format("{}", lns));
+  { // crop
+    auto p1 = rich::panel(lns);
+    auto p2 = rich::panel(compact);
+    p1.contents_spec.width = p2.contents_spec.width = 10;
+    CHECK(fmt::format("{}", p2) == fmt::format("{}", p1));
+  }
+  { // wrap
+    lns.wrap = compact.wrap = true;
+    auto p1 = rich::panel(lns);
+    auto p2 = rich::panel(compact);
+    p1.contents_spec.width = p2.contents_spec.width = 10;
+    CHECK(fmt::format("{}", p2) == fmt::format("{}", p1));
+  }
+  const std::string other = "other";
+  CHECK_THROWS_AS(rich::compact_lines<char>(
+                    contents, std::array{rich::segment<char>(other)}),
+                  rich::runtime_error);
+}
+
+TEST_CASE("style", "[style][text_arena]") {
+  using namespace std::literals;
+  auto make_location = [](int line) {
+    rich::text_arena arena(16);
+    auto file = arena.append(std::string("main.cpp"));
+    auto where = arena.format("{}:{} in {}", file, line, "main()");
+    CHECK(arena.chunk_count() > 1);
+    auto lns = rich::lines<char>{{where, {}}};
+    return rich::adopt(std::move(arena), std::move(lns));
+  };
+  auto location = make_location(42);
+  CHECK(fmt::format("{}", location) == "\0main.cpp:42 in main()"s);
+  CHECK(fmt::format("{}", rich::panel(location))
+        == fmt::format("{}", rich::panel(location.value)));
+  auto copy = location;
+  location = {};
+  CHECK(fmt::format("{}", copy) == "\0main.cpp:42 in main()"s);
+
+  // views are stable across chunks and moves
+  rich::text_arena arena(8);
+  std::vector<std::string_view> views;
+  for (std::size_t i = 0; i < 100; ++i)
+    views.push_back(arena.format("{:0>{}}", i, i % 20));
+  auto moved = std::move(arena);
+  CHECK(arena.empty());
+  CHECK(moved.chunk_count() > 1);
+  for (std::size_t i = 0; i < 100; ++i)
+    CHECK(views[i] == fmt::format("{:0>{}}", i, i % 20));
+  CHECK(moved.append("") == "");
+}
+
+TEST_CASE("style", "[style][static_table]") {
+  const std::string contents = "int main() {\n  return 0;\n}\n";
+  auto lns = rich::lines(rich::syntax_highlight(contents));
+  rich::enumerate numbered(lns);
+  rich::lines<char> message{{"message", {}}};
+  { // same as table
+    auto t1 = rich::table(lns, numbered, message);
+    auto t2 = rich::static_table(lns, numbered, message);
+    t1.title = t2.title = "title";
+    CHECK(fmt::format("{}", t2) == fmt::format("{}", t1));
+    t1.contents_spec.width = t2.contents_spec.width = 12;
+    CHECK(fmt::format("{}", t2) == fmt::format("{}", t1));
+    t1.nomatter = t2.nomatter = true;
+    CHECK(fmt::format("{}", t2) == fmt::format("{}", t1));
+  }
+  { // nested panels
+    auto inner = rich::panel(lns);
+    inner.contents_spec.width = 30;
+    auto fused = rich::panel<decltype(inner)>(inner);
+    auto erased = rich::panel(rich::cell<char>(inner));
+    fused.contents_spec.width = erased.contents_spec.width = 40;
+    fused.contents_spec.align = erased.contents_spec.align =
+      rich::align_t::center;
+    CHECK(fmt::format("{}", fused) == fmt::format("{}", erased));
+    fused.contents_spec.width = erased.contents_spec.width = 20;
+    CHECK(fmt::format("{}", fused) == fmt::format("{}", erased));
+    auto fused2 = rich::panel<decltype(fused)>(fused);
+    auto erased2 = rich::panel(rich::cell<char>(erased));
+    CHECK(fmt::format("{}", fused2) == fmt::format("{}", erased2));
+    auto t1 = rich::table(inner, message, fused);
+    auto t2 = rich::static_table(inner, message, fused);
+    CHECK(fmt::format("{}", t2) == fmt::format("{}", t1));
+    inner.nomatter = true;
+    inner.contents = rich::lines<char>();
+    CHECK(fmt::format("{}", rich::panel<decltype(inner)>(inner))
+          == fmt::format("{}", rich::panel(rich::cell<char>(inner))));
+  }
+}
+
+TEST_CASE("style", "[style][instrument]") {
+  if (not rich::instrument::enabled)
+    return;
+  const std::string contents = "int main() {\n  return 0;\n}\n";
+  auto highlighted = rich::syntax_highlight(contents);
+  auto find = [](const rich::instrument::snapshot& snap,
+                 std::string_view name) {
+    for (const auto& c : snap.entries)
+      if (c.name == name)
+        return c;
+    return rich::instrument::counters{};
+  };
+  auto total = [](const rich::instrument::snapshot& snap) {
+    std::uint64_t n = 0;
+    for (const auto& c : snap.entries)
+      n += c.text_bytes + c.padding_bytes + c.escape_bytes;
+    return n;
+  };
+
+  rich::instrument::counting_resource resource;
+  auto pnl = rich::panel(rich::lines<char>(std::allocator_arg, &resource,
+                                           highlighted));
+  pnl.contents_spec.width = 12;
+  rich::instrument::reset();
+  const auto str = fmt::format("{}", pnl);
+  auto snap = rich::instrument::take_snapshot();
+  const auto l = find(snap, "rich::lines<char>");
+  const auto p = find(snap, "rich::panel<rich::lines<char> >");
+  CHECK(l.lines == 4);
+  CHECK(l.text_bytes == 17);
+  CHECK(l.allocations == 0); // cropping a line does not allocate
+  CHECK(p.lines == 6);
+  CHECK(p.nanoseconds >= l.nanoseconds);
+  CHECK(p.set_style_calls > 0);
+  // every byte but the line delimiters is counted once
+  CHECK(total(snap) + p.lines == str.size());
+
+  // wrapping allocates the layout through the allocator of the lines once
+  auto allocations = [](const rich::instrument::snapshot& s) {
+    std::uint64_t n = 0;
+    for (const auto& c : s.entries)
+      n += c.allocations;
+    return n;
+  };
+  pnl.contents.wrap = true;
+  rich::instrument::reset();
+  (void)fmt::format("{}", pnl);
+  CHECK(allocations(rich::instrument::take_snapshot()) > 0);
+  rich::instrument::reset();
+  (void)fmt::format("{}", pnl);
+  CHECK(allocations(rich::instrument::take_snapshot()) == 0);
+  pnl.contents.wrap = false;
+
+  rich::lines<char> lns(highlighted);
+  rich::enumerate numbered(lns);
+  auto tbl = rich::table(lns, numbered, rich::panel<decltype(pnl)>(pnl));
+  rich::instrument::reset();
+  const auto str2 = fmt::format("{}", tbl);
+  snap = rich::instrument::take_snapshot();
+  CHECK(find(snap, "rich::cell<char>").lines == 16);
+  CHECK(total(snap) + find(snap, "rich::table<char>").lines == str2.size());
+
+  const auto rendered = fmt::format("{}", rich::instrument::to_table(snap));
+  CHECK(rendered.find("rich::enumerate<rich::lines<char> >")
+        != std::string::npos);
+
+  // rich::format は測るための描画を数えない
+  rich::instrument::reset();
+  (void)rich::format(tbl);
+  const auto measured = rich::instrument::take_snapshot();
+  for (const auto& b : snap.entries) {
+    const auto a = find(measured, b.name);
+    CHECK(a.lines == b.lines);
+    CHECK(a.text_bytes == b.text_bytes);
+    CHECK(a.padding_bytes == b.padding_bytes);
+    CHECK(a.escape_bytes == b.escape_bytes);
+    CHECK(a.set_style_calls == b.set_style_calls);
+  }
+}
+
+TEST_CASE("style", "[style][trace]") {
+  if (not rich::trace::enabled) {
+    CHECK(rich::trace::dump() == "{\"traceEvents\":[]}\n");
+    return;
+  }
+  rich::thread_pool pool(4);
+  rich::trace::clear();
+  rich::trace::start();
+  CHECK(rich::trace::recording());
+  {
+    const auto contents = rich::get_file_contents(__FILE__);
+    rich::line_index index(std::string_view{contents});
+    auto lns = rich::lines(rich::syntax_highlight(index.slice(0, 20)));
+    auto tbl = rich::table<char>();
+    for (std::size_t i = 0; i < 8; ++i)
+      tbl.push_back(rich::panel(lns));
+    std::string str;
+    rich::parallel_format_to(std::back_inserter(str), tbl, pool);
+    CHECK(str == fmt::format("{}", tbl));
+  }
+  { // 2 つのスレッドで同時に描く
+    std::atomic<std::size_t> arrived = 0;
+    auto lns = rich::lines<char>{{"a\nbb", {}}};
+    pool.parallel_for(2, [&](std::size_t, std::size_t) {
+      (void)fmt::format("{}", rich::panel(lns));
+      ++arrived;
+      while (arrived.load() < 2) {
+      }
+    });
+  }
+  rich::trace::stop();
+  const auto json = rich::trace::dump();
+  { // nothing is recorded after stop
+    auto lns = rich::lines<char>{{"a\nbb", {}}};
+    (void)fmt::format("{}", lns);
+    CHECK(rich::trace::dump() == json);
+  }
+  CHECK(json.starts_with("{\"traceEvents\":["));
+  CHECK(json.ends_with("],\"displayTimeUnit\":\"ns\"}\n"));
+  for (const auto* cat : {"read", "index", "highlight", "layout", "write",
+                          "line"})
+    CHECK(json.find(fmt::format("\"cat\":\"{}\"", cat)) != std::string::npos);
+  CHECK(json.find("\"name\":\"get_file_contents\"") != std::string::npos);
+  CHECK(json.find("\"name\":\"regex_search\"") != std::string::npos);
+  CHECK(json.find("\"name\":\"rich::table<char>\"") != std::string::npos);
+  CHECK(json.find("\"name\":\"rich::panel<rich::lines<char> >\"")
+        != std::string::npos);
+  // 描いたスレッドごとに記録される
+  std::size_t tids = 0;
+  for (std::size_t tid = 1; tid < 64; ++tid)
+    if (json.find(fmt::format("\"tid\":{}}}", tid)) != std::string::npos)
+      ++tids;
+  CHECK(tids > 1);
+
+  { // formatted_size の描画は 1 つの measure として記録する
+    rich::trace::clear();
+    rich::trace::start();
+    (void)rich::format(rich::panel(rich::lines<char>{{"a\nbb", {}}}));
+    rich::trace::stop();
+    const auto measured = rich::trace::dump();
+    auto count = [&measured](std::string_view cat) {
+      const auto key = fmt::format("\"cat\":\"{}\"", cat);
+      std::size_t n = 0;
+      for (auto i = measured.find(key); i != std::string::npos;
+           i = measured.find(key, i + 1))
+        ++n;
+      return n;
+    };
+    CHECK(count("measure") == 1);
+    CHECK(count("write") == 1);
+    CHECK(count("line") == 6); // 4 lines of the panel and 2 of its contents
+  }
+
+  rich::trace::clear();
+  CHECK(rich::trace::dump()
+        == "{\"traceEvents\":[\n],\"displayTimeUnit\":\"ns\"}\n");
+}
+
+TEST_CASE("style", "[style][hexdump]") {
+  using namespace std::literals;
+  const auto bytes = "Hello, world!\n\0\0\x01\xff"sv;
+  auto plain = [](rich::hexdump<char> hd) {
+    hd.offset_style = hd.zero_style = hd.control_style = {};
+    return hd;
+  };
+  { // hexdump -C と同じ
+    auto hd = plain(rich::hexdump(bytes));
+    CHECK(hd.size() == 2);
+    CHECK(fmt::format("{}", hd)
+          == "\0" "00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 21 0a 00 00  "
+             "|Hello, world!...|\n"
+             "00000010  01 ff                                             "
+             "|..|"sv);
+    CHECK(rich::format(hd) == fmt::format("{}", hd));
+  }
+  { // groups, offset and no ASCII gutter
+    auto hd = plain(rich::hexdump(bytes.substr(0, 7)));
+    hd.bytes_per_line = 4;
+    hd.group_size = 2;
+    hd.start_offset = 0xffffffff;
+    hd.ascii = false;
+    CHECK(fmt::format("{}", hd)
+          == "\0" "0ffffffff  48 65  6c 6c\n"
+             "100000003  6f 2c  20   "sv);
+    hd.group_size = 0;
+    CHECK(fmt::format("{}", hd)
+          == "\0" "0ffffffff  48 65 6c 6c\n"
+             "100000003  6f 2c 20   "sv);
+  }
+  { // crop
+    auto hd = plain(rich::hexdump(bytes));
+    CHECK(rich::format(hd, 14)
+          == "\0" "00000000  48 6\n"
+             "00000010  01 f"sv);
+    rich::line_formatter<rich::hexdump<char>, char> fmtr(hd);
+    fmtr.skip();
+    CHECK(fmtr.formatted_size() == 64);
+    std::string str;
+    fmtr.format_to(std::back_inserter(str));
+    CHECK(str.size() == 64);
+    CHECK(not fmtr);
+  }
+  { // 種類ごとに style が変わるところだけ escape する
+    auto hd = rich::hexdump(bytes.substr(12, 5));
+    const auto expected = fmt::format(
+      "\x1b[2m00000000\x1b[0m  21 \x1b[33m0a\x1b[0m \x1b[2m00 00\x1b[0m "
+      "\x1b[33m01\x1b[0m{}|!\x1b[33m.\x1b[0m\x1b[2m..\x1b[0m\x1b[33m.\x1b[0m|",
+      std::string(36, ' '));
+    CHECK(fmt::format("{}", hd) == "\0"s + expected);
+  }
+  { // 8 byte ずつの変換と 1 byte ずつの変換が一致する
+    std::array<unsigned char, 256 + 7> all{};
+    for (std::size_t i = 0; i < all.size(); ++i)
+      all[i] = static_cast<unsigned char>(i);
+    auto hd = plain(rich::hexdump(all));
+    hd.bytes_per_line = all.size();
+    hd.group_size = 0;
+    hd.ascii = false;
+    auto expected = "\0" "00000000  "s;
+    for (const auto c : all)
+      expected += fmt::format("{:02x} ", c);
+    expected.pop_back();
+    CHECK(fmt::format("{}", hd) == expected);
+  }
+  { // 大きな buffer も 1 行ずつ書く
+    std::vector<unsigned char> large(1 << 18);
+    for (std::size_t i = 0; i < large.size(); ++i)
+      large[i] = static_cast<unsigned char>(i);
+    auto hd = rich::hexdump(large);
+    std::size_t expected = 0;
+    for (rich::line_formatter<rich::hexdump<char>, char> fmtr(hd); fmtr;
+         fmtr.skip())
+      expected += fmtr.formatted_size() + 1;
+    CHECK(hd.size() == large.size() / 16);
+    auto str = fmt::format("{}", plain(hd));
+    CHECK(str.size() == expected);
+    CHECK(str.ends_with("\n0003fff0  f0 f1 f2 f3 f4 f5 f6 f7  "
+                        "f8 f9 fa fb fc fd fe ff  |................|"));
+  }
+}
+
 // TEST_CASE("style", "[style][squared]") {}